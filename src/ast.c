@@ -2,16 +2,25 @@
 #include "lexer.h"
 #include "token.h"
 #include "utils/ast_data.h"
+#include "utils/interner.h"
+#include "utils/recovery.h"
+#include "utils/thread.h"
+#include "utils/type_registry.h"
 
 #include <assert.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
-#include <string.h>
 
-#define array_length(array) (sizeof(array) / sizeof(array[0]))
+// The parser consults ast_data for names declared so far. Threads parsing
+// function bodies each point it at their own view.
+_Thread_local ASTData* ast_data = NULL;
 
-ASTData* ast_data = NULL;
+// Bodies ast_build_lexed leaves out, as token indices of their opening brace
+static _Thread_local const size_t* ast_skipped = NULL;
+static _Thread_local size_t ast_skipped_count = 0;
 
 void node_error(Node* node, const char* fmt, ...) {
     va_list args;
@@ -22,19 +31,34 @@ void node_error(Node* node, const char* fmt, ...) {
     bool idents[50] = {false};
     print_node(node, idents, 0);
     va_end(args);
-    exit(1);
+    recovery_fail();
+}
+
+// Literal nodes carry the value the lexer parsed
+static Node* ast_create_literal(Lexer* lexer, NodeType type, Token* token) {
+    Node* literal = create_node(type, lexer_token_value(lexer, token), token->line, token->column);
+    if (type == NODE_FLOAT_LITERAL) {
+        literal->real = token->real;
+    } else {
+        literal->integer = token->integer;
+    }
+    literal->literal_type = token->literal_type;
+    return literal;
 }
 
 AST* ast_create() {
     AST* ast = calloc(1, sizeof(AST));
     ast->root = NULL;
+    ast->arena = arena_create(AST_ARENA_CHUNK_SIZE);
+    node_set_arena(ast->arena);
     ast_data = ast_data_create();
     ast->data = ast_data;
     return ast;
 }
 
 void ast_destroy(AST* ast) {
-    destroy_node(ast->root);
+    ast_data_destroy(ast->data);
+    arena_destroy(ast->arena);
     free(ast);
 }
 
@@ -51,15 +75,61 @@ void _ast_error(int src_line, char* file, Token* token, char* message, ...) {
     vfprintf(stderr, message, args);
     fprintf(stderr, "\n");
     va_end(args);
-    exit(1);
+    recovery_fail();
+}
+
+// Whether ast belongs to the session bound to the calling thread
+static bool ast_is_bound(AST* ast) {
+    return interner != NULL && type_registry != NULL && ast_data == ast->data && node_get_arena() == ast->arena;
 }
 
 void ast_build(AST* ast, Lexer* lexer) {
-    lexer_lexall(lexer, false);
+    assert(ast_is_bound(ast) && "AST of a compiler session not bound to this thread");
+    lexer_stream(lexer);
     lexer_set_cursor(lexer, 0);
     ast->root = ast_parse_program(lexer);
 }
 
+void ast_build_parallel(AST* ast, Lexer* lexer, size_t threads) {
+    lexer_lexall(lexer, false);
+    ast_build_lexed(ast, lexer, threads, NULL, 0);
+}
+
+void ast_build_lexed(AST* ast, Lexer* lexer, size_t threads, const size_t* skipped, size_t skipped_count) {
+    assert(ast_is_bound(ast) && "AST of a compiler session not bound to this thread");
+    jmp_buf recovery;
+    jmp_buf* outer = recovery_point;
+    ast_skipped = skipped;
+    ast_skipped_count = skipped_count;
+    // An error must not leave the skipped bodies to the next file on this thread
+    if (setjmp(recovery) != 0) {
+        recovery_point = outer;
+        ast_skipped = NULL;
+        ast_skipped_count = 0;
+        recovery_fail();
+    }
+    recovery_point = &recovery;
+    lexer_set_cursor(lexer, 0);
+    ast->root = ast_parse_program_parallel(lexer, threads);
+    recovery_point = outer;
+    ast_skipped = NULL;
+    ast_skipped_count = 0;
+}
+
+static bool ast_body_skipped(size_t body_start) {
+    size_t low = 0;
+    size_t high = ast_skipped_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (ast_skipped[middle] < body_start) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < ast_skipped_count && ast_skipped[low] == body_start;
+}
+
 Node* ast_parse_program(Lexer* lexer) {
     Node* program = create_node(NODE_PROGRAM, NULL, 0, 0);
     Token* token = lexer_peek_token(lexer, 0);
@@ -77,7 +147,7 @@ Node* ast_parse_statement(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     Node* statement = NULL;
     if (token->type == TOKEN_KEYWORD) {
-        KeywordType keyword_type = get_keyword_type(token->value);
+        KeywordType keyword_type = token->keyword;
         if (keyword_type == KEYWORD_FNC) {
             statement = ast_parse_function(lexer);
         } else if (keyword_type == KEYWORD_IF) {
@@ -98,91 +168,88 @@ Node* ast_parse_statement(Lexer* lexer) {
         } else if (keyword_type == KEYWORD_STRUCT) {
             statement = ast_parse_struct_declaration(lexer);
         } else {
-            ast_error(token, "Unexpected keyword", token->value);
+            ast_error(token, "Unexpected keyword", lexer_token_value(lexer, token));
         }
     } else if (token->type == TOKEN_IDENTIFIER) {
         Token* next_token = lexer_peek_token(lexer, 1);
-        if (next_token->type == TOKEN_PUNCTUATION && strcmp(next_token->value, "(") == 0) {
+        if (next_token->punctuation == PUNCTUATION_LPAREN) {
             statement = ast_parse_call_expression(lexer);
             lexer_advance_cursor(lexer, 1);
-        } else if (next_token->type == TOKEN_PUNCTUATION && strcmp(next_token->value, ":") == 0) {
+        } else if (next_token->punctuation == PUNCTUATION_COLON) {
             next_token = lexer_peek_token(lexer, 2);
             if (next_token->type == TOKEN_TYPEANNOTATION) {
-                DataType* data_type = get_data_type(next_token->value, ast_data);
+                DataType* data_type = get_data_type(lexer_token_value(lexer, next_token), ast_data);
                 if (data_type->id == DATA_TYPE_PTR) {
                     statement = ast_parse_pointer_declaration(lexer);
                 } else {
                     statement = ast_parse_variable_declaration(lexer);
                 }
-            } else if (next_token->type == TOKEN_PUNCTUATION && strcmp(next_token->value, "[") == 0) {
+            } else if (next_token->punctuation == PUNCTUATION_LBRACKET) {
                 statement = ast_parse_array_declaration(lexer);
             } else {
-                ast_error(next_token, "Expected type annotation after colon in variable declaration, got %s\n", next_token->value);
+                ast_error(next_token, "Expected type annotation after colon in variable declaration, got %s\n",
+                          lexer_token_value(lexer, next_token));
             }
-        } else if (next_token->type == TOKEN_PUNCTUATION && strcmp(next_token->value, "[") == 0) {
+        } else if (next_token->punctuation == PUNCTUATION_LBRACKET) {
             statement = ast_parse_array_assignment(lexer);
-        } else if (next_token->type == TOKEN_OPERATOR && strcmp(next_token->value, "=") == 0) {
-            for (size_t i = 0; i < ast_data->variable_count; i++) {
-                if (strcmp(ast_data->variables[i]->name, token->value) == 0) {
-                    return ast_parse_assignment(lexer);
-                }
+        } else if (next_token->op == OPERATOR_ASSIGN) {
+            if (ast_data_find_variable(ast_data, token->id) != NULL) {
+                return ast_parse_assignment(lexer);
             }
-            for (size_t i = 0; i < ast_data->array_count; i++) {
-                if (strcmp(ast_data->arrays[i]->name, token->value) == 0) {
-                    return ast_parse_array_assignment(lexer);
-                }
+            if (ast_data_find_array(ast_data, token->id) != NULL) {
+                return ast_parse_array_assignment(lexer);
             }
-            for (size_t i = 0; i < ast_data->pointer_count; i++) {
-                if (strcmp(ast_data->pointers[i]->name, token->value) == 0) {
-                    return ast_parse_assignment(lexer);
-                }
+            if (ast_data_find_pointer(ast_data, token->id) != NULL) {
+                return ast_parse_assignment(lexer);
             }
 
-            ast_error(token, "Cannot assign to undeclared variable %s\n", token->value);
-        } else if (next_token->type == TOKEN_OPERATOR && strcmp(next_token->value, ".") == 0) {
+            ast_error(token, "Cannot assign to undeclared variable %s\n", lexer_token_value(lexer, token));
+        } else if (next_token->op == OPERATOR_DOT) {
             statement = ast_parse_struct_member_assignment(lexer);
         }
     } else if (token->type == TOKEN_PUNCTUATION) {
-        if (strcmp(token->value, ";") == 0) {
+        if (token->punctuation == PUNCTUATION_SEMICOLON) {
             statement = create_node(NODE_NULL_LITERAL, NULL, token->line, token->column);
         }
     } else if (token->type == TOKEN_COMMENT) {
-        statement = create_node(NODE_COMMENT, token->value, token->line, token->column);
+        statement = create_node(NODE_COMMENT, lexer_token_value(lexer, token), token->line, token->column);
         lexer_advance_cursor(lexer, 1);
     } else if (token->type == TOKEN_DOC_COMMENT) {
-        statement = create_node(NODE_DOC_COMMENT, token->value, token->line, token->column);
+        statement = create_node(NODE_DOC_COMMENT, lexer_token_value(lexer, token), token->line, token->column);
         lexer_advance_cursor(lexer, 1);
     } else if (token->type == TOKEN_OPERATOR) {
-        if (strcmp(token->value, "*") == 0) {
+        if (token->op == OPERATOR_MUL) {
             statement = ast_parse_pointer_deref(lexer);
         } else {
-            ast_error(token, "Unexpected operator: %s\n", token->value);
+            ast_error(token, "Unexpected operator: %s\n", lexer_token_value(lexer, token));
         }
     } else {
-        ast_error(token, "Unexpected token: %s\n", token->value);
+        ast_error(token, "Unexpected token: %s\n", lexer_token_value(lexer, token));
     }
 
-    if (lexer_peek_token(lexer, 0)->type == TOKEN_PUNCTUATION && strcmp(lexer_peek_token(lexer, 0)->value, ";") == 0) {
+    if (lexer_peek_token(lexer, 0)->punctuation == PUNCTUATION_SEMICOLON) {
         lexer_advance_cursor(lexer, 1);
     }
 
     return statement;
 }
 
-Node* ast_parse_function(Lexer* lexer) {
+// Parses everything up to the body or the closing semicolon, leaving the
+// cursor on either
+static Node* ast_parse_function_signature(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     assert(token->type == TOKEN_KEYWORD);
-    assert(get_keyword_type(token->value) == KEYWORD_FNC);
+    assert(token->keyword == KEYWORD_FNC);
     Node* function = create_node(NODE_FUNCTION_DECLARATION, NULL, token->line, token->column);
     token = lexer_peek_token(lexer, 1);
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier after function keyword, got %s\n", token->value);
+        ast_error(token, "Expected identifier after function keyword, got %s\n", lexer_token_value(lexer, token));
     }
 
-    Node* identifier = create_node(NODE_IDENTIFIER, token->value, token->line, token->column);
+    Node* identifier = create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
     node_add_child(function, identifier);
     token = lexer_peek_token(lexer, 2);
-    assert(token->type == TOKEN_PUNCTUATION && strcmp(token->value, "(") == 0 && "Function arguments must be enclosed in parentheses");
+    assert(token->punctuation == PUNCTUATION_LPAREN && "Function arguments must be enclosed in parentheses");
     lexer_advance_cursor(lexer, 3);
     while (true) {
         Node* argument = ast_parse_function_argument(lexer);
@@ -194,37 +261,43 @@ Node* ast_parse_function(Lexer* lexer) {
     }
 
     token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, ":") != 0) {
-        ast_error(token, "Expected colon after function arguments, got %s\n", token->value);
+    if (token->punctuation != PUNCTUATION_COLON) {
+        ast_error(token, "Expected colon after function arguments, got %s\n", lexer_token_value(lexer, token));
     }
     token = lexer_peek_token(lexer, 1);
     if (token->type != TOKEN_TYPEANNOTATION) {
-        ast_error(token, "Expected type annotation after colon in function declaration, got %s\n", token->value);
+        ast_error(token, "Expected type annotation after colon in function declaration, got %s\n", lexer_token_value(lexer, token));
     }
     Node* type = NULL;
-    if (get_data_type(token->value, ast_data)->id == DATA_TYPE_PTR) {
+    if (get_data_type(lexer_token_value(lexer, token), ast_data)->id == DATA_TYPE_PTR) {
         lexer_advance_cursor(lexer, 1);
         type = ast_parse_pointer_type(lexer, NULL);
     } else {
-        type = create_node(NODE_TYPE, token->value, token->line, token->column);
+        type = create_node(NODE_TYPE, lexer_token_value(lexer, token), token->line, token->column);
         lexer_advance_cursor(lexer, 2);
     }
     node_add_child(function, type);
 
     token = lexer_peek_token(lexer, 0);
-    if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ";") == 0) {
-        lexer_advance_cursor(lexer, 1);
-    } else {
-        lexer_advance_cursor(lexer, -1);
-
-        if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, "{") != 0) {
-            ast_error(token, "Expected opening brace or \";\" after function declaration, got %s\n", token->value);
-        }
-        lexer_advance_cursor(lexer, 1);
-        Node* block = ast_parse_block(lexer);
-        node_add_child(function, block);
-        lexer_advance_cursor(lexer, 1);
+    if (token->punctuation != PUNCTUATION_SEMICOLON && token->punctuation != PUNCTUATION_LBRACE) {
+        ast_error(token, "Expected opening brace or \";\" after function declaration, got %s\n", lexer_token_value(lexer, token));
     }
+    return function;
+}
+
+// Parses the body the cursor is on into function. Names declared in it are
+// forgotten again once it ends.
+static void ast_parse_function_body(Lexer* lexer, Node* function) {
+    ASTDataScope scope = ast_data_open_scope(ast_data);
+    Node* block = ast_parse_block(lexer);
+    node_add_child(function, block);
+    lexer_advance_cursor(lexer, 1);
+    ast_data_close_scope(ast_data, scope);
+}
+
+static void ast_register_function(Node* function) {
+    Node* identifier = function->children[0];
+    Node* type = NULL;
     const char* arguments[100] = {0};
     DataType* argument_types[100] = {0};
     size_t argument_count = 0;
@@ -237,6 +310,8 @@ Node* ast_parse_function(Lexer* lexer) {
                 }
             }
             argument_count++;
+        } else if (function->children[i]->type == NODE_TYPE) {
+            type = function->children[i];
         }
     }
     const char** args = calloc(argument_count, sizeof(char*));
@@ -246,56 +321,229 @@ Node* ast_parse_function(Lexer* lexer) {
     }
     Function* function_data = ast_data_function_create(identifier->data, get_data_type(type->data, ast_data), args, arg_types, argument_count);
     ast_data_add_function(ast_data, function_data);
+}
+
+// Moves the cursor from the opening brace of a body past its closing brace.
+// Returns false, leaving the cursor alone, for bodies that declare functions
+// or structs, as those change what the code after them sees.
+static bool ast_skip_function_body(Lexer* lexer) {
+    size_t depth = 0;
+    size_t offset = 0;
+    while (true) {
+        Token* token = lexer_peek_token(lexer, offset++);
+        if (token->type == TOKEN_EOF) {
+            ast_error(token, "Expected closing brace at the end of function body\n");
+        } else if (token->type == TOKEN_KEYWORD && (token->keyword == KEYWORD_FNC || token->keyword == KEYWORD_STRUCT)) {
+            return false;
+        } else if (token->type == TOKEN_PUNCTUATION && token->punctuation == PUNCTUATION_LBRACE) {
+            depth++;
+        } else if (token->type == TOKEN_PUNCTUATION && token->punctuation == PUNCTUATION_RBRACE && --depth == 0) {
+            lexer_advance_cursor(lexer, offset);
+            return true;
+        }
+    }
+}
+
+Node* ast_parse_function(Lexer* lexer) {
+    Node* function = ast_parse_function_signature(lexer);
+    Token* token = lexer_peek_token(lexer, 0);
+    if (token->punctuation == PUNCTUATION_SEMICOLON) {
+        lexer_advance_cursor(lexer, 1);
+    } else if (ast_body_skipped(lexer->index)) {
+        ast_skip_function_body(lexer);
+    } else {
+        ast_parse_function_body(lexer, function);
+    }
+    ast_register_function(function);
     return function;
 }
 
+// One top-level function body for ast_parse_program_parallel
+typedef struct ASTFunctionJob {
+    Node* function;      // Signature from the pre-scan, the worker adds the body
+    size_t body_start;   // Token index of the opening brace
+    ASTDataScope scope;  // What ast_parse_program would have seen at the body
+} ASTFunctionJob;
+
+typedef struct ASTParseWorker {
+    Thread thread;
+    Lexer lexer;  // Own cursor over the shared tokens
+    Arena* arena;
+    ASTData* shared;
+    Interner* interner;  // Of the session that started the worker
+    TypeRegistry* types;
+    ASTFunctionJob* jobs;
+    size_t job_count;
+    atomic_size_t* next_job;
+    atomic_bool* failed;
+} ASTParseWorker;
+
+// Returns false if the body had an error, which has been reported
+static bool ast_parse_job(ASTParseWorker* worker, ASTFunctionJob* job) {
+    jmp_buf recovery;
+    ast_data = ast_data_view_create(worker->shared, job->scope);
+    if (setjmp(recovery) != 0) {
+        recovery_point = NULL;
+        ast_data_view_destroy(ast_data, job->scope);
+        return false;
+    }
+    recovery_point = &recovery;
+    lexer_set_cursor(&worker->lexer, job->body_start);
+    ast_parse_function_body(&worker->lexer, job->function);
+    recovery_point = NULL;
+    ast_data_view_destroy(ast_data, job->scope);
+    return true;
+}
+
+static void ast_parse_worker(void* arg) {
+    ASTParseWorker* worker = arg;
+    interner = worker->interner;
+    type_registry = worker->types;
+    node_set_arena(worker->arena);
+    while (!atomic_load(worker->failed)) {
+        size_t index = atomic_fetch_add(worker->next_job, 1);
+        if (index >= worker->job_count) {
+            break;
+        }
+        if (!ast_parse_job(worker, &worker->jobs[index])) {
+            atomic_store(worker->failed, true);
+        }
+    }
+}
+
+Node* ast_parse_program_parallel(Lexer* lexer, size_t threads) {
+    assert(!lexer->streaming);
+    if (threads <= 1) {
+        return ast_parse_program(lexer);
+    }
+    Node* program = create_node(NODE_PROGRAM, NULL, 0, 0);
+    ASTFunctionJob* jobs = NULL;
+    size_t job_count = 0;
+    size_t job_capacity = 0;
+
+    // Pre-scan: everything but the bodies, in source order
+    Token* token = lexer_peek_token(lexer, 0);
+    while (token->type != TOKEN_EOF) {
+        if (token->type != TOKEN_KEYWORD || token->keyword != KEYWORD_FNC) {
+            Node* statement = ast_parse_statement(lexer);
+            if (statement != NULL) {
+                node_add_child(program, statement);
+            }
+            token = lexer_peek_token(lexer, 0);
+            continue;
+        }
+
+        Node* function = ast_parse_function_signature(lexer);
+        size_t body_start = lexer->index;
+        ASTDataScope scope = ast_data_open_scope(ast_data);
+        if (lexer_peek_token(lexer, 0)->punctuation == PUNCTUATION_SEMICOLON) {
+            lexer_advance_cursor(lexer, 1);
+        } else if (ast_body_skipped(body_start)) {
+            ast_skip_function_body(lexer);
+        } else if (ast_skip_function_body(lexer)) {
+            if (job_count == job_capacity) {
+                job_capacity = job_capacity == 0 ? 64 : job_capacity * 2;
+                jobs = realloc(jobs, job_capacity * sizeof(ASTFunctionJob));
+            }
+            jobs[job_count++] = (ASTFunctionJob){function, body_start, scope};
+        } else {
+            ast_parse_function_body(lexer, function);
+        }
+        ast_register_function(function);
+        node_add_child(program, function);
+
+        token = lexer_peek_token(lexer, 0);
+        if (token->type == TOKEN_PUNCTUATION && token->punctuation == PUNCTUATION_SEMICOLON) {
+            lexer_advance_cursor(lexer, 1);
+            token = lexer_peek_token(lexer, 0);
+        }
+    }
+
+    size_t worker_count = threads < job_count ? threads : job_count;
+    ASTParseWorker* workers = calloc(worker_count, sizeof(ASTParseWorker));
+    atomic_size_t next_job = 0;
+    atomic_bool failed = false;
+    for (size_t i = 0; i < worker_count; i++) {
+        workers[i].lexer = *lexer;
+        workers[i].lexer.views = NULL;  // Views made by the worker, merged back after the join
+        workers[i].arena = arena_create(AST_ARENA_CHUNK_SIZE);
+        workers[i].shared = ast_data;
+        workers[i].interner = interner;
+        workers[i].types = type_registry;
+        workers[i].jobs = jobs;
+        workers[i].job_count = job_count;
+        workers[i].next_job = &next_job;
+        workers[i].failed = &failed;
+        if (!thread_start(&workers[i].thread, ast_parse_worker, &workers[i])) {
+            fprintf(stderr, "Error: Could not start parser thread\n");
+            exit(1);
+        }
+    }
+    for (size_t i = 0; i < worker_count; i++) {
+        thread_join(&workers[i].thread);
+        lexer_merge_views(lexer, &workers[i].lexer);
+        arena_merge(node_get_arena(), workers[i].arena);
+    }
+    free(workers);
+    free(jobs);
+    // The workers reported their errors, the session fails once they are done
+    if (atomic_load(&failed)) {
+        recovery_fail();
+    }
+    return program;
+}
+
 Node* ast_parse_function_argument(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     bool is_ellipsis = false;
-    if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ")") == 0) {
+    if (token->punctuation == PUNCTUATION_RPAREN) {
         lexer_advance_cursor(lexer, 1);
         return NULL;
     }
     token = lexer_peek_token(lexer, 0);
-    if (token->type == TOKEN_OPERATOR && strcmp(token->value, "...") == 0) {
+    if (token->op == OPERATOR_ELLIPSIS) {
         is_ellipsis = true;
         Token* next_token = lexer_peek_token(lexer, 1);
-        if (next_token->type != TOKEN_PUNCTUATION || strcmp(next_token->value, ")") != 0) {
-            ast_error(next_token, "Expected closing parenthesis after ellipsis in function argument, got %s\n", next_token->value);
+        if (next_token->punctuation != PUNCTUATION_RPAREN) {
+            ast_error(next_token, "Expected closing parenthesis after ellipsis in function argument, got %s\n",
+                      lexer_token_value(lexer, next_token));
         }
     } else if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier as function argument, got %s\n", token->value);
+        ast_error(token, "Expected identifier as function argument, got %s\n", lexer_token_value(lexer, token));
     }
-    Node* argument = create_node(NODE_FUNCTION_ARGUMENT, token->value, token->line, token->column);
+    Node* argument = create_node(NODE_FUNCTION_ARGUMENT, lexer_token_value(lexer, token), token->line, token->column);
     if (is_ellipsis) {
+        argument->op = OPERATOR_ELLIPSIS;
         lexer_advance_cursor(lexer, 1);
         return argument;
     }
     token = lexer_peek_token(lexer, 1);
-    if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ":") != 0 && !is_ellipsis) {
-        ast_error(token, "Expected type declaration after function argument identifier, got %s\n", token->value);
+    if (token->type == TOKEN_PUNCTUATION && token->punctuation != PUNCTUATION_COLON && !is_ellipsis) {
+        ast_error(token, "Expected type declaration after function argument identifier, got %s\n", lexer_token_value(lexer, token));
     }
     token = lexer_peek_token(lexer, 2);
     if (token->type != TOKEN_TYPEANNOTATION) {
-        ast_error(token, "Expected type identifier after function argument type declaration, got %s\n", token->value);
+        ast_error(token, "Expected type identifier after function argument type declaration, got %s\n",
+                  lexer_token_value(lexer, token));
     }
     lexer_advance_cursor(lexer, 2);
     Node* type = NULL;
-    if (get_data_type(token->value, ast_data)->id == DATA_TYPE_PTR) {
+    if (get_data_type(lexer_token_value(lexer, token), ast_data)->id == DATA_TYPE_PTR) {
         token = lexer_peek_token(lexer, 0);
         type = ast_parse_pointer_type(lexer, NULL);
     } else {
-        type = create_node(NODE_TYPE, token->value, token->line, token->column);
+        type = create_node(NODE_TYPE, lexer_token_value(lexer, token), token->line, token->column);
         lexer_advance_cursor(lexer, 1);
     }
     node_add_child(argument, type);
     token = lexer_peek_token(lexer, 0);
-    if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ",") == 0) {
+    if (token->punctuation == PUNCTUATION_COMMA) {
         lexer_advance_cursor(lexer, 1);
-    } else if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ")") == 0) {
+    } else if (token->punctuation == PUNCTUATION_RPAREN) {
         lexer_advance_cursor(lexer, 0);
     } else {
-        ast_error(token, "Expected comma or closing parenthesis after function argument, got %s\n", token->value);
+        ast_error(token, "Expected comma or closing parenthesis after function argument, got %s\n",
+                  lexer_token_value(lexer, token));
     }
     return argument;
 }
@@ -304,9 +552,9 @@ Node* ast_parse_if_statement(Lexer* lexer, bool is_elif) {
     Token* token = lexer_peek_token(lexer, 0);
     assert(token->type == TOKEN_KEYWORD);
     if (is_elif) {
-        assert(get_keyword_type(token->value) == KEYWORD_ELIF);
+        assert(token->keyword == KEYWORD_ELIF);
     } else {
-        assert(get_keyword_type(token->value) == KEYWORD_IF);
+        assert(token->keyword == KEYWORD_IF);
     }
     Node* if_statement;
     if (is_elif) {
@@ -316,13 +564,13 @@ Node* ast_parse_if_statement(Lexer* lexer, bool is_elif) {
     }
     lexer_advance_cursor(lexer, 1);
     Node* expression = ast_parse_expression(lexer);
-    if (strcmp(lexer_peek_token(lexer, 0)->value, ")") == 0) {
+    if (lexer_peek_token(lexer, 0)->punctuation == PUNCTUATION_RPAREN) {
         lexer_advance_cursor(lexer, 1);
     }
     node_add_child(if_statement, expression);
     token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, "{") != 0) {
-        ast_error(token, "Expected opening brace after if statement expression, got %s\n", token->value);
+    if (token->punctuation != PUNCTUATION_LBRACE) {
+        ast_error(token, "Expected opening brace after if statement expression, got %s\n", lexer_token_value(lexer, token));
     }
 
     Node* block = ast_parse_block(lexer);
@@ -331,22 +579,22 @@ Node* ast_parse_if_statement(Lexer* lexer, bool is_elif) {
 
     token = lexer_peek_token(lexer, 0);
 
-    if (token->type == TOKEN_KEYWORD && !is_elif && get_keyword_type(token->value) == KEYWORD_ELIF) {
+    if (token->type == TOKEN_KEYWORD && !is_elif && token->keyword == KEYWORD_ELIF) {
         while (true) {
             Node* elif_statement = ast_parse_if_statement(lexer, true);
             node_add_child(if_statement, elif_statement);
             token = lexer_peek_token(lexer, 0);
-            if (token->type != TOKEN_KEYWORD || get_keyword_type(token->value) != KEYWORD_ELIF) {
+            if (token->type != TOKEN_KEYWORD || token->keyword != KEYWORD_ELIF) {
                 break;
             }
         }
     }
 
-    if (token->type == TOKEN_KEYWORD && !is_elif && get_keyword_type(token->value) == KEYWORD_ELSE) {
+    if (token->type == TOKEN_KEYWORD && !is_elif && token->keyword == KEYWORD_ELSE) {
         lexer_advance_cursor(lexer, 1);
         token = lexer_peek_token(lexer, 0);
-        if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, "{") != 0) {
-            ast_error(token, "Expected opening brace after else keyword, got %s\n", token->value);
+        if (token->punctuation != PUNCTUATION_LBRACE) {
+            ast_error(token, "Expected opening brace after else keyword, got %s\n", lexer_token_value(lexer, token));
         }
         Node* else_block = ast_parse_block(lexer);
         Node* else_statement = create_node(NODE_ELSE_STATEMENT, NULL, token->line, token->column);
@@ -361,17 +609,17 @@ Node* ast_parse_if_statement(Lexer* lexer, bool is_elif) {
 Node* ast_parse_while_statement(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     assert(token->type == TOKEN_KEYWORD);
-    assert(get_keyword_type(token->value) == KEYWORD_WHILE);
+    assert(token->keyword == KEYWORD_WHILE);
     Node* while_statement = create_node(NODE_WHILE_STATEMENT, NULL, token->line, token->column);
     lexer_advance_cursor(lexer, 1);
     Node* expression = ast_parse_expression(lexer);
-    if (strcmp(lexer_peek_token(lexer, 0)->value, ")") == 0) {
+    if (lexer_peek_token(lexer, 0)->punctuation == PUNCTUATION_RPAREN) {
         lexer_advance_cursor(lexer, 1);
     }
     node_add_child(while_statement, expression);
     token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, "{") != 0) {
-        ast_error(token, "Expected opening brace after if statement expression, got %s\n", token->value);
+    if (token->punctuation != PUNCTUATION_LBRACE) {
+        ast_error(token, "Expected opening brace after if statement expression, got %s\n", lexer_token_value(lexer, token));
     }
 
     Node* block = ast_parse_block(lexer);
@@ -383,23 +631,21 @@ Node* ast_parse_while_statement(Lexer* lexer) {
 
 Node* ast_parse_block(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, "{") != 0) {
-        ast_error(token, "Expected opening brace at beginning of block, got %s\n", token->value);
+    if (token->punctuation != PUNCTUATION_LBRACE) {
+        ast_error(token, "Expected opening brace at beginning of block, got %s\n", lexer_token_value(lexer, token));
     }
 
     Node* block = create_node(NODE_BLOCK_STATEMENT, NULL, token->line, token->column);
     lexer_advance_cursor(lexer, 1);
     while (true) {
         token = lexer_peek_token(lexer, 0);
-        if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, "}") == 0) {
+        if (token->punctuation == PUNCTUATION_RBRACE) {
             break;
         }
         Node* statement = ast_parse_statement(lexer);
         if (statement == NULL) {
             break;
-        } else if (statement->type == NODE_COMMENT) {
-            destroy_node(statement);
-        } else {
+        } else if (statement->type != NODE_COMMENT) {
             node_add_child(block, statement);
         }
     }
@@ -409,17 +655,19 @@ Node* ast_parse_block(Lexer* lexer) {
 Node* ast_parse_variable_declaration(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier as left-hand side of variable declaration, got %s\n", token->value);
+        ast_error(token, "Expected identifier as left-hand side of variable declaration, got %s\n",
+                  lexer_token_value(lexer, token));
     }
 
-    Node* identifier = create_node(NODE_IDENTIFIER, token->value, token->line, token->column);
+    Node* identifier = create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
     token = lexer_peek_token(lexer, 1);
-    if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ":") == 0) {
+    if (token->punctuation == PUNCTUATION_COLON) {
         token = lexer_peek_token(lexer, 2);
         if (token->type != TOKEN_TYPEANNOTATION) {
-            ast_error(token, "Expected type annotation after colon in variable declaration, got %s\n", token->value);
+            ast_error(token, "Expected type annotation after colon in variable declaration, got %s\n",
+                      lexer_token_value(lexer, token));
         }
-        Node* type = create_node(NODE_TYPE, token->value, token->line, token->column);
+        Node* type = create_node(NODE_TYPE, lexer_token_value(lexer, token), token->line, token->column);
         token = lexer_peek_token(lexer, 3);
 
         Variable* variable = ast_data_variable_create(identifier->data, get_data_type(type->data, ast_data));
@@ -427,17 +675,19 @@ Node* ast_parse_variable_declaration(Lexer* lexer) {
         identifier->type = NODE_VARIABLE_DECLARATION;
         node_add_child(identifier, type);
 
-        if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ";") == 0) {
+        if (token->punctuation == PUNCTUATION_SEMICOLON) {
             lexer_advance_cursor(lexer, 4);
             return identifier;
-        } else if (token->type == TOKEN_OPERATOR && strcmp(token->value, "=") == 0) {
+        } else if (token->op == OPERATOR_ASSIGN) {
             lexer_advance_cursor(lexer, 2);
-            lexer->tokens[lexer->index].type = TOKEN_IDENTIFIER;
-            lexer_graveyard(lexer->tokens[lexer->index].value);
-            lexer->tokens[lexer->index].value = identifier->data;
+            Token* relabeled = lexer_peek_token(lexer, 0);
+            relabeled->type = TOKEN_IDENTIFIER;
+            relabeled->value = identifier->data;
+            relabeled->id = interner_find(interner, identifier->data);
             return identifier;
         } else {
-            ast_error(token, "Expected semicolon or assignment operator after type annotation in variable declaration, got %s\n", token->value);
+            ast_error(token, "Expected semicolon or assignment operator after type annotation in variable declaration, got %s\n",
+                      lexer_token_value(lexer, token));
         }
     }
     return NULL;
@@ -446,36 +696,36 @@ Node* ast_parse_variable_declaration(Lexer* lexer) {
 Node* ast_parse_array_declaration(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier as left-hand side of array declaration, got %s\n", token->value);
+        ast_error(token, "Expected identifier as left-hand side of array declaration, got %s\n", lexer_token_value(lexer, token));
     }
 
-    Node* identifier = create_node(NODE_IDENTIFIER, token->value, token->line, token->column);
+    Node* identifier = create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
     token = lexer_peek_token(lexer, 3);
     if (token->type != TOKEN_TYPEANNOTATION) {
-        ast_error(token, "Expected type annotation after colon in array declaration, got %s\n", token->value);
+        ast_error(token, "Expected type annotation after colon in array declaration, got %s\n", lexer_token_value(lexer, token));
     }
-    Node* type = create_node(NODE_TYPE, token->value, token->line, token->column);
+    Node* type = create_node(NODE_TYPE, lexer_token_value(lexer, token), token->line, token->column);
 
     size_t idx = 4;
     size_t array_dims_count = 0;
     Node** array_dims = calloc(100, sizeof(Node*));
     while (true) {
         token = lexer_peek_token(lexer, idx);
-        if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, "]") == 0) {
+        if (token->punctuation == PUNCTUATION_RBRACKET) {
             idx++;
             break;
         }
 
         token = lexer_peek_token(lexer, idx);
-        if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ";") == 0) {
+        if (token->punctuation == PUNCTUATION_SEMICOLON) {
             idx++;
         }
 
         token = lexer_peek_token(lexer, idx);
         if (token->type != TOKEN_NUMBER) {
-            ast_error(token, "Expected number as array size, got %s\n", token->value);
+            ast_error(token, "Expected number as array size, got %s\n", lexer_token_value(lexer, token));
         }
-        Node* array_dim = create_node(NODE_NUMERIC_LITERAL, token->value, token->line, token->column);
+        Node* array_dim = ast_create_literal(lexer, NODE_NUMERIC_LITERAL, token);
         array_dims[array_dims_count] = array_dim;
         array_dims_count++;
         idx++;
@@ -495,17 +745,19 @@ Node* ast_parse_array_declaration(Lexer* lexer) {
 
     token = lexer_peek_token(lexer, idx);
 
-    if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ";") == 0) {
+    if (token->punctuation == PUNCTUATION_SEMICOLON) {
         lexer_advance_cursor(lexer, idx + 1);
         return array_declaration;
-    } else if (token->type == TOKEN_OPERATOR && strcmp(token->value, "=") == 0) {
+    } else if (token->op == OPERATOR_ASSIGN) {
         lexer_advance_cursor(lexer, idx - 1);
-        lexer->tokens[lexer->index].type = TOKEN_IDENTIFIER;
-        lexer_graveyard(lexer->tokens[lexer->index].value);
-        lexer->tokens[lexer->index].value = identifier->data;
+        Token* relabeled = lexer_peek_token(lexer, 0);
+        relabeled->type = TOKEN_IDENTIFIER;
+        relabeled->value = identifier->data;
+        relabeled->id = interner_find(interner, identifier->data);
         return array_declaration;
     } else {
-        ast_error(token, "Expected semicolon or assignment operator after array declaration, got %s\n", token->value);
+        ast_error(token, "Expected semicolon or assignment operator after array declaration, got %s\n",
+                  lexer_token_value(lexer, token));
     }
     return NULL;
 }
@@ -513,31 +765,19 @@ Node* ast_parse_array_declaration(Lexer* lexer) {
 Node* ast_parse_assignment(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier as left-hand side of assignment, got %s\n", token->value);
+        ast_error(token, "Expected identifier as left-hand side of assignment, got %s\n", lexer_token_value(lexer, token));
     }
-    Node* identifier = create_node(NODE_IDENTIFIER, token->value, token->line, token->column);
+    Node* identifier = create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
     token = lexer_peek_token(lexer, 1);
 
-    if (token->type == TOKEN_OPERATOR && strcmp(token->value, "=") == 0) {
+    if (token->op == OPERATOR_ASSIGN) {
         if (ast_data->variable_count == 0 && ast_data->array_count == 0 && ast_data->pointer_count == 0) {
             ast_error(token, "Cannot assign to undeclared variable %s\n", (char*)identifier->data);
         }
 
-        bool is_pointer = false;
-        for (size_t i = 0; i < ast_data->pointer_count; i++) {
-            if (strcmp(ast_data->pointers[i]->name, identifier->data) == 0) {
-                is_pointer = true;
-                break;
-            }
-        }
-        if (!is_pointer) {
-            for (size_t i = 0; i < ast_data->variable_count; i++) {
-                if (strcmp(ast_data->variables[i]->name, identifier->data) == 0) {
-                    break;
-                } else if (i == ast_data->variable_count - 1) {
-                    ast_error(token, "Cannot assign to undeclared variable %s\n", (char*)identifier->data);
-                }
-            }
+        bool is_pointer = ast_data_find_pointer(ast_data, identifier->id) != NULL;
+        if (!is_pointer && ast_data->variable_count > 0 && ast_data_find_variable(ast_data, identifier->id) == NULL) {
+            ast_error(token, "Cannot assign to undeclared variable %s\n", (char*)identifier->data);
         }
 
         lexer_advance_cursor(lexer, 2);
@@ -547,7 +787,7 @@ Node* ast_parse_assignment(Lexer* lexer) {
         node_add_child(assignment, expression);
         return assignment;
     } else {
-        ast_error(token, "Expected assignment operator after identifier in assignment, got %s\n", token->value);
+        ast_error(token, "Expected assignment operator after identifier in assignment, got %s\n", lexer_token_value(lexer, token));
     }
     return NULL;
 }
@@ -556,13 +796,13 @@ Node* ast_parse_array_expression(Lexer* lexer, size_t array_dim) {
     Token* token = lexer_peek_token(lexer, 0);
     Node* array_expression = create_node(NODE_ARRAY_EXPRESSION, NULL, token->line, token->column);
     if (array_dim == 1) {
-        if (token->type != TOKEN_PUNCTUATION && strcmp(token->value, "[") != 0) {
-            ast_error(token, "Expected opening bracket in array expression, got %s\n", token->value);
+        if (token->punctuation != PUNCTUATION_LBRACKET) {
+            ast_error(token, "Expected opening bracket in array expression, got %s\n", lexer_token_value(lexer, token));
         }
         lexer_advance_cursor(lexer, 1);
         while (true) {
             Token* token = lexer_peek_token(lexer, 0);
-            if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, "]") == 0) {
+            if (token->punctuation == PUNCTUATION_RBRACKET) {
                 lexer_advance_cursor(lexer, 1);
                 break;
             }
@@ -570,27 +810,28 @@ Node* ast_parse_array_expression(Lexer* lexer, size_t array_dim) {
             node_add_child(array_expression, expression);
         }
     } else {
-        if (token->type != TOKEN_PUNCTUATION && strcmp(token->value, "[") != 0) {
-            ast_error(token, "Expected opening bracket in array expression, got %s\n", token->value);
+        if (token->punctuation != PUNCTUATION_LBRACKET) {
+            ast_error(token, "Expected opening bracket in array expression, got %s\n", lexer_token_value(lexer, token));
         }
         lexer_advance_cursor(lexer, 1);
         while (true) {
             Node* array_expression_child = ast_parse_array_expression(lexer, array_dim - 1);
             node_add_child(array_expression, array_expression_child);
             Token* token = lexer_peek_token(lexer, 0);
-            if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ",") == 0) {
+            if (token->punctuation == PUNCTUATION_COMMA) {
                 lexer_advance_cursor(lexer, 1);
                 continue;
-            } else if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, "]") == 0) {
+            } else if (token->punctuation == PUNCTUATION_RBRACKET) {
                 lexer_advance_cursor(lexer, 1);
                 break;
             } else {
-                ast_error(token, "Expected comma or closing bracket in array expression, got %s\n", token->value);
+                ast_error(token, "Expected comma or closing bracket in array expression, got %s\n",
+                          lexer_token_value(lexer, token));
             }
         }
     }
     token = lexer_peek_token(lexer, 0);
-    if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ";") == 0) {
+    if (token->punctuation == PUNCTUATION_SEMICOLON) {
         lexer_advance_cursor(lexer, 1);
     }
     return array_expression;
@@ -602,41 +843,25 @@ Node* ast_parse_array_assignment(Lexer* lexer) {
     // 2. Assigning the entire array
     Token* token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier as left-hand side of array assignment, got %s\n", token->value);
-    }
-
-    size_t array_idx = 0;
-    bool found_array = false;
-    for (size_t i = 0; i < ast_data->array_count; i++) {
-        if (strcmp(ast_data->arrays[i]->name, token->value) == 0) {
-            array_idx = i;
-            found_array = true;
-            break;
-        }
+        ast_error(token, "Expected identifier as left-hand side of array assignment, got %s\n", lexer_token_value(lexer, token));
     }
 
+    Array* array = ast_data_find_array(ast_data, token->id);
     bool is_pointer = false;
-    if (!found_array) {
-        for (size_t i = 0; i < ast_data->pointer_count; i++) {
-            if (strcmp(ast_data->pointers[i]->name, token->value) == 0) {
-                array_idx = i;
-                found_array = true;
-                is_pointer = true;
-                break;
-            }
-        }
+    if (array == NULL && ast_data_find_pointer(ast_data, token->id) != NULL) {
+        is_pointer = true;
     }
 
-    if (!found_array) {
-        ast_error(token, "Cannot assign to undeclared array %s\n", token->value);
+    if (array == NULL && !is_pointer) {
+        ast_error(token, "Cannot assign to undeclared array %s\n", lexer_token_value(lexer, token));
     }
 
     if (!is_pointer) {
-        size_t array_dim = ast_data->arrays[array_idx]->dimension;
+        size_t array_dim = array->dimension;
 
-        Node* identifier = create_node(NODE_IDENTIFIER, token->value, token->line, token->column);
+        Node* identifier = create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
         token = lexer_peek_token(lexer, 1);
-        if (token->type == TOKEN_OPERATOR && strcmp(token->value, "=") == 0) {
+        if (token->op == OPERATOR_ASSIGN) {
             // Assigning the entire array
             lexer_advance_cursor(lexer, 2);
             Node* expression = ast_parse_array_expression(lexer, array_dim);
@@ -644,7 +869,7 @@ Node* ast_parse_array_assignment(Lexer* lexer) {
             node_add_child(assignment, identifier);
             node_add_child(assignment, expression);
             return assignment;
-        } else if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, "[") == 0) {
+        } else if (token->punctuation == PUNCTUATION_LBRACKET) {
             // Assigning to a single element
             // example syntax: arr[0][3][4] = 1;
             lexer_advance_cursor(lexer, 1);
@@ -654,7 +879,7 @@ Node* ast_parse_array_assignment(Lexer* lexer) {
                 node_add_child(identifier, array_index);
                 dim_depth--;
                 Token* ntok = lexer_peek_token(lexer, 0);
-                if (ntok->type == TOKEN_OPERATOR && strcmp(ntok->value, "=") == 0) {
+                if (ntok->op == OPERATOR_ASSIGN) {
                     break;
                 }
             }
@@ -663,8 +888,9 @@ Node* ast_parse_array_assignment(Lexer* lexer) {
 
             token = lexer_peek_token(lexer, 0);
 
-            if (token->type != TOKEN_OPERATOR && strcmp(token->value, "=") != 0) {
-                ast_error(token, "Expected = after array index of array length %d, got %s\n", array_dim, token->value);
+            if (token->op != OPERATOR_ASSIGN) {
+                ast_error(token, "Expected = after array index of array length %d, got %s\n",
+                          array_dim, lexer_token_value(lexer, token));
             }
 
             lexer_advance_cursor(lexer, 1);
@@ -674,12 +900,13 @@ Node* ast_parse_array_assignment(Lexer* lexer) {
             node_add_child(assignment, expression);
             return assignment;
         } else {
-            ast_error(token, "Expected assignment operator or opening bracket after identifier in array assignment, got %s\n", token->value);
+            ast_error(token, "Expected assignment operator or opening bracket after identifier in array assignment, got %s\n",
+                      lexer_token_value(lexer, token));
         }
     } else {
-        Node* identifier = create_node(NODE_IDENTIFIER, token->value, token->line, token->column);
+        Node* identifier = create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
         token = lexer_peek_token(lexer, 1);
-        if (token->type == TOKEN_OPERATOR && strcmp(token->value, "=") == 0) {
+        if (token->op == OPERATOR_ASSIGN) {
             // Assigning the entire array
             lexer_advance_cursor(lexer, 2);
             Node* expression = ast_parse_expression(lexer);
@@ -687,7 +914,7 @@ Node* ast_parse_array_assignment(Lexer* lexer) {
             node_add_child(assignment, identifier);
             node_add_child(assignment, expression);
             return assignment;
-        } else if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, "[") == 0) {
+        } else if (token->punctuation == PUNCTUATION_LBRACKET) {
             // Assigning to a single element
             // example syntax: arr[0][3][4] = 1;
             lexer_advance_cursor(lexer, 1);
@@ -697,15 +924,16 @@ Node* ast_parse_array_assignment(Lexer* lexer) {
                 node_add_child(identifier, array_index);
                 dim_depth++;
                 Token* ntok = lexer_peek_token(lexer, 0);
-                if (ntok->type == TOKEN_OPERATOR && strcmp(ntok->value, "=") == 0) {
+                if (ntok->op == OPERATOR_ASSIGN) {
                     break;
                 }
             }
 
             token = lexer_peek_token(lexer, 0);
 
-            if (token->type != TOKEN_OPERATOR && strcmp(token->value, "=") != 0) {
-                ast_error(token, "Expected = after array index of array length %d, got %s\n", dim_depth, token->value);
+            if (token->op != OPERATOR_ASSIGN) {
+                ast_error(token, "Expected = after array index of array length %d, got %s\n",
+                          dim_depth, lexer_token_value(lexer, token));
             }
 
             lexer_advance_cursor(lexer, 1);
@@ -715,7 +943,8 @@ Node* ast_parse_array_assignment(Lexer* lexer) {
             node_add_child(assignment, expression);
             return assignment;
         } else {
-            ast_error(token, "Expected assignment operator or opening bracket after identifier in pointer as array assignment, got %s\n", token->value);
+            ast_error(token, "Expected assignment operator or opening bracket after identifier in pointer as array assignment, got %s\n",
+                      lexer_token_value(lexer, token));
         }
     }
     return NULL;
@@ -723,33 +952,34 @@ Node* ast_parse_array_assignment(Lexer* lexer) {
 
 Node* ast_parse_pointer_type(Lexer* lexer, size_t* ptr_depth) {
     Token* token = lexer_peek_token(lexer, 0);
-    assert(token->type == TOKEN_TYPEANNOTATION && get_data_type(token->value, ast_data)->id == DATA_TYPE_PTR);
-    Node* pointer_type = create_node(NODE_TYPE, token->value, token->line, token->column);
+    assert(token->type == TOKEN_TYPEANNOTATION && get_data_type(lexer_token_value(lexer, token), ast_data)->id == DATA_TYPE_PTR);
+    Node* pointer_type = create_node(NODE_TYPE, lexer_token_value(lexer, token), token->line, token->column);
     lexer_advance_cursor(lexer, 1);
     token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_OPERATOR || strcmp(token->value, "<") != 0) {
-        ast_error(token, "Expected opening angle bracket after pointer type, got %s\n", token->value);
+    if (token->op != OPERATOR_LT) {
+        ast_error(token, "Expected opening angle bracket after pointer type, got %s\n", lexer_token_value(lexer, token));
     }
     lexer_advance_cursor(lexer, 1);
     token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_TYPEANNOTATION) {
-        ast_error(token, "Expected type annotation after opening angle bracket in pointer type, got %s\n", token->value);
+        ast_error(token, "Expected type annotation after opening angle bracket in pointer type, got %s\n",
+                  lexer_token_value(lexer, token));
     }
-    if (get_data_type(token->value, ast_data)->id == DATA_TYPE_PTR) {
+    if (get_data_type(lexer_token_value(lexer, token), ast_data)->id == DATA_TYPE_PTR) {
         Node* nested_pointer_type = ast_parse_pointer_type(lexer, ptr_depth);
         node_add_child(pointer_type, nested_pointer_type);
         if (ptr_depth != NULL) {
             *ptr_depth += 1;
         }
     } else {
-        Node* type = create_node(NODE_TYPE, token->value, token->line, token->column);
+        Node* type = create_node(NODE_TYPE, lexer_token_value(lexer, token), token->line, token->column);
         node_add_child(pointer_type, type);
         lexer_advance_cursor(lexer, 1);
     }
 
     token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_OPERATOR || strcmp(token->value, ">") != 0) {
-        ast_error(token, "Expected closing angle bracket after pointer type, got %s\n", token->value);
+    if (token->op != OPERATOR_GT) {
+        ast_error(token, "Expected closing angle bracket after pointer type, got %s\n", lexer_token_value(lexer, token));
     }
     lexer_advance_cursor(lexer, 1);
     return pointer_type;
@@ -758,12 +988,12 @@ Node* ast_parse_pointer_type(Lexer* lexer, size_t* ptr_depth) {
 Node* ast_parse_pointer_declaration(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     assert(token->type == TOKEN_IDENTIFIER);
-    Node* identifier = create_node(NODE_IDENTIFIER, token->value, token->line, token->column);
+    Node* identifier = create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
     token = lexer_peek_token(lexer, 1);
-    assert(token->type == TOKEN_PUNCTUATION && strcmp(token->value, ":") == 0);
+    assert(token->punctuation == PUNCTUATION_COLON);
     lexer_advance_cursor(lexer, 2);
     token = lexer_peek_token(lexer, 0);
-    assert(token->type == TOKEN_TYPEANNOTATION && get_data_type(token->value, ast_data)->id == DATA_TYPE_PTR);
+    assert(token->type == TOKEN_TYPEANNOTATION && get_data_type(lexer_token_value(lexer, token), ast_data)->id == DATA_TYPE_PTR);
     size_t ptr_depth = 0;
     Node* type = ast_parse_pointer_type(lexer, &ptr_depth);
     Node* pointer_declaration = create_node(NODE_POINTER_DECLARATION, NULL, token->line, token->column);
@@ -786,367 +1016,289 @@ Node* ast_parse_pointer_declaration(Lexer* lexer) {
     ast_data_add_pointer(ast_data, pointer);
 
     token = lexer_peek_token(lexer, 0);
-    if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ";") == 0) {
+    if (token->punctuation == PUNCTUATION_SEMICOLON) {
         lexer_advance_cursor(lexer, 1);
         return pointer_declaration;
-    } else if (token->type == TOKEN_OPERATOR && strcmp(token->value, "=") == 0) {
+    } else if (token->op == OPERATOR_ASSIGN) {
         lexer_advance_cursor(lexer, -1);
-        lexer->tokens[lexer->index].type = TOKEN_IDENTIFIER;
-        lexer_graveyard(lexer->tokens[lexer->index].value);
-        lexer->tokens[lexer->index].value = identifier->data;
+        Token* relabeled = lexer_peek_token(lexer, 0);
+        relabeled->type = TOKEN_IDENTIFIER;
+        relabeled->value = identifier->data;
+        relabeled->id = interner_find(interner, identifier->data);
         return pointer_declaration;
     } else {
-        ast_error(token, "Expected semicolon or assignment operator after pointer declaration, got %s\n", token->value);
-        exit(1);
+        ast_error(token, "Expected semicolon or assignment operator after pointer declaration, got %s\n",
+                  lexer_token_value(lexer, token));
     }
 }
 
 Node* ast_parse_pointer_deref(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
-    assert(token->type == TOKEN_OPERATOR && strcmp(token->value, "*") == 0);
+    assert(token->op == OPERATOR_MUL);
     lexer_advance_cursor(lexer, 1);
     token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier after pointer dereference, got %s\n", token->value);
+        ast_error(token, "Expected identifier after pointer dereference, got %s\n", lexer_token_value(lexer, token));
     }
-    Node* pointer_deref = create_node(NODE_POINTER_DEREF, token->value, token->line, token->column);
+    Node* pointer_deref = create_node(NODE_POINTER_DEREF, lexer_token_value(lexer, token), token->line, token->column);
 
     lexer_advance_cursor(lexer, 1);
     token = lexer_peek_token(lexer, 0);
-    if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ";") == 0) {
+    if (token->punctuation == PUNCTUATION_SEMICOLON) {
         ast_error(token, "Dereferencing a pointer without assignind something to it is not allowed\n");
-    } else if (token->type == TOKEN_OPERATOR && strcmp(token->value, "=") == 0) {
+    } else if (token->op == OPERATOR_ASSIGN) {
         lexer_advance_cursor(lexer, 1);
         Node* expression = ast_parse_expression(lexer);
         node_add_child(pointer_deref, expression);
     } else {
-        ast_error(token, "Expected semicolon or assignment operator after pointer dereference, got %s\n", token->value);
-        exit(1);
+        ast_error(token, "Expected semicolon or assignment operator after pointer dereference, got %s\n",
+                  lexer_token_value(lexer, token));
     }
     return pointer_deref;
 }
 
-const char* unary_precedence[] = {
-    "~",
-    "!",
-    "-",
-    "+",
-    "&",
-    "*",
-    "--",
-    "++",
+// Binding power of each binary operator, higher binds tighter. Operators left
+// at 0 can not appear between two operands.
+static const uint8_t binary_precedence[OPERATOR_TOTAL] = {
+    [OPERATOR_ELLIPSIS] = 1,
+    [OPERATOR_ASSIGN] = 2,
+    [OPERATOR_ADD_ASSIGN] = 2,
+    [OPERATOR_SUB_ASSIGN] = 2,
+    [OPERATOR_MUL_ASSIGN] = 2,
+    [OPERATOR_DIV_ASSIGN] = 2,
+    [OPERATOR_MOD_ASSIGN] = 2,
+    [OPERATOR_OR] = 3,
+    [OPERATOR_AND] = 4,
+    [OPERATOR_BIT_OR] = 5,
+    [OPERATOR_BIT_XOR] = 6,
+    [OPERATOR_BIT_AND] = 7,
+    [OPERATOR_EQ] = 8,
+    [OPERATOR_NE] = 8,
+    [OPERATOR_LT] = 9,
+    [OPERATOR_LE] = 9,
+    [OPERATOR_GT] = 9,
+    [OPERATOR_GE] = 9,
+    [OPERATOR_SHL] = 10,
+    [OPERATOR_SHR] = 10,
+    [OPERATOR_ADD] = 11,
+    [OPERATOR_SUB] = 11,
+    [OPERATOR_MUL] = 12,
+    [OPERATOR_DIV] = 12,
+    [OPERATOR_MOD] = 12,
 };
 
-const char* binary_precedence[] = {
-    "...",
-    "%=",
-    "/=",
-    "*=",
-    "-=",
-    "+=",
-    "=",
-    "||",
-    "&&",
-    "|",
-    "^",
-    "&",
-    "!=",
-    "==",
-    ">=",
-    ">",
-    "<=",
-    "<",
-    ">>",
-    "<<",
-    "-",
-    "+",
-    "%",
-    "/",
-    "*",
+// Assignments group to the right, every other binary operator to the left
+static const bool binary_right_associative[OPERATOR_TOTAL] = {
+    [OPERATOR_ASSIGN] = true,
+    [OPERATOR_ADD_ASSIGN] = true,
+    [OPERATOR_SUB_ASSIGN] = true,
+    [OPERATOR_MUL_ASSIGN] = true,
+    [OPERATOR_DIV_ASSIGN] = true,
+    [OPERATOR_MOD_ASSIGN] = true,
 };
 
-Node* ast_parse_expression_flat(Lexer* lexer) {
-    Token* token = lexer_peek_token(lexer, 0);
-    Node* expression = create_node(NODE_EXPRESSION, NULL, token->line, token->column);
-    size_t paren_count = 0;
-    while (true) {
-        token = lexer_peek_token(lexer, 0);
+static const bool unary_operators[OPERATOR_TOTAL] = {
+    [OPERATOR_BIT_NOT] = true,
+    [OPERATOR_NOT] = true,
+    [OPERATOR_SUB] = true,
+    [OPERATOR_ADD] = true,
+    [OPERATOR_BIT_AND] = true,
+    [OPERATOR_MUL] = true,
+    [OPERATOR_DEC] = true,
+    [OPERATOR_INC] = true,
+};
 
-        switch (token->type) {
-            case TOKEN_IDENTIFIER: {
-                Token* next_tok = lexer_peek_token(lexer, 1);
-                if (next_tok->type == TOKEN_PUNCTUATION && strcmp(next_tok->value, "(") == 0) {
-                    // Check if the function call returns void
-                    for (size_t i = 0; i < ast_data->function_count; i++) {
-                        if (strcmp(ast_data->functions[i]->name, token->value) == 0) {
-                            if (ast_data->functions[i]->return_type->id == DATA_TYPE_VOID) {
-                                ast_error(token, "Cannot use void function \"%s\" in expression\n", token->value);
-                            }
-                        }
-                    }
-                    Node* call_exp = ast_parse_call_expression(lexer);
-                    node_add_child(expression, call_exp);
-                } else if (next_tok->type == TOKEN_PUNCTUATION && strcmp(next_tok->value, "[") == 0) {
-                    lexer_advance_cursor(lexer, 1);
-                    Node* array_element = create_node(NODE_ARRAY_ELEMENT, token->value, token->line, token->column);
-                    while (true) {
-                        Node* array_index = ast_parse_array_index(lexer);
-                        node_add_child(array_element, array_index);
-                        Token* tok = lexer_peek_token(lexer, 0);
-                        if (tok->type != TOKEN_PUNCTUATION || strcmp(tok->value, "[") != 0) {
-                            lexer_advance_cursor(lexer, -1);
-                            break;
-                        }
-                    }
-                    node_add_child(expression, array_element);
-                    break;
-                } else if (next_tok->type == TOKEN_OPERATOR && (strcmp(next_tok->value, ".") == 0)) {
-                    Node* struct_access = ast_parse_struct_access(lexer);
-                    node_add_child(expression, struct_access);
-                    break;
-                } else {
-                    node_add_child(expression, create_node(NODE_IDENTIFIER, token->value, token->line, token->column));
-                }
-                break;
-            }
-            case TOKEN_STRING:
-                node_add_child(expression, create_node(NODE_STRING_LITERAL, token->value, token->line, token->column));
-                break;
-            case TOKEN_NUMBER:
-                node_add_child(expression, create_node(NODE_NUMERIC_LITERAL, token->value, token->line, token->column));
-                break;
-            case TOKEN_FLOAT_NUM:
-                node_add_child(expression, create_node(NODE_FLOAT_LITERAL, token->value, token->line, token->column));
-                break;
-            case TOKEN_KEYWORD:
-                if (get_keyword_type(token->value) == KEYWORD_TRUE) {
-                    node_add_child(expression, create_node(NODE_TRUE_LITERAL, token->value, token->line, token->column));
-                } else if (get_keyword_type(token->value) == KEYWORD_FALSE) {
-                    node_add_child(expression, create_node(NODE_FALSE_LITERAL, token->value, token->line, token->column));
-                } else if (get_keyword_type(token->value) == KEYWORD_NULL) {
-                    node_add_child(expression, create_node(NODE_NULL_LITERAL, token->value, token->line, token->column));
-                } else {
-                    ast_error(token, "Unexpected keyword in expression: %s\n", token->value);
-                }
-                break;
-            case TOKEN_OPERATOR:
-                node_add_child(expression, create_node(NODE_OPERATOR, token->value, token->line, token->column));
-                break;
-            case TOKEN_PUNCTUATION:
-                if (strcmp(token->value, "(") == 0) {
-                    lexer_advance_cursor(lexer, 1);
-                    paren_count++;
-                    Node* paren_expression = ast_parse_expression(lexer);
-                    node_add_child(expression, paren_expression);
-                    continue;
-                } else if (strcmp(token->value, ")") == 0) {
-                    if (paren_count == 0) {
-                        return expression;
-                    } else {
-                        paren_count--;
-                        if (paren_count == 0) {
-                            lexer_advance_cursor(lexer, 1);
-                            return expression;
-                        }
-                    }
-                } else if (strcmp(token->value, ",") == 0) {
-                    lexer_advance_cursor(lexer, 1);
-                    return expression;
-                } else if (strcmp(token->value, ";") == 0) {
-                    lexer_advance_cursor(lexer, 1);
-                    return expression;
-                } else if (strcmp(token->value, "]") == 0) {
-                    return expression;
-                } else {
-                    ast_error(token, "Unexpected punctuation in expression: %s\n", token->value);
-                }
-                break;
-            case TOKEN_COMMENT:
-                break;
-            default: {
-                ast_error(token, "Unexpected token in expression: %s\n", token->value);
-            }
-        }
+// Comments may sit anywhere inside an expression and are dropped
+static Token* ast_expression_peek(Lexer* lexer) {
+    Token* token = lexer_peek_token(lexer, 0);
+    while (token->type == TOKEN_COMMENT) {
         lexer_advance_cursor(lexer, 1);
+        token = lexer_peek_token(lexer, 0);
     }
-
-    return expression;
+    return token;
 }
 
-Node* ast_expression_descent(Node* expression) {
-    if (expression->type != NODE_EXPRESSION) {
-        return expression;
-    }
-
-    if (expression->num_children == 0) {
-        node_error(expression, "Empty expression");
-    } else if (expression->num_children == 1) {
-        Node* child = expression->children[0];
-        if (child->type == NODE_EXPRESSION) {
-            return ast_expression_descent(child);
-        } else {
-            return expression;
-        }
-    } else if (expression->num_children == 2) {
-        bool has_unary = false;
-        for (size_t i = 0; i < expression->num_children; i++) {
-            Node* child = expression->children[i];
-            if (child->type == NODE_OPERATOR) {
-                for (size_t j = 0; j < array_length(unary_precedence); j++) {
-                    if (strcmp(child->data, unary_precedence[j]) == 0) {
-                        has_unary = true;
-                        break;
-                    }
+static Node* ast_parse_binary_expression(Lexer* lexer, uint8_t min_precedence);
+
+// Parses a single operand: a literal, a name, a call, an array element, a
+// struct access, a parenthesised expression or a unary operator applied to
+// another operand. Leaves the cursor on the token after it.
+static Node* ast_parse_operand(Lexer* lexer) {
+    Token* token = ast_expression_peek(lexer);
+    switch (token->type) {
+        case TOKEN_IDENTIFIER: {
+            Token* next_tok = lexer_peek_token(lexer, 1);
+            if (next_tok->type == TOKEN_PUNCTUATION && next_tok->punctuation == PUNCTUATION_LPAREN) {
+                // Check if the function call returns void
+                Function* function = ast_data_find_function(ast_data, token->id);
+                if (function != NULL && function->return_type->id == DATA_TYPE_VOID) {
+                    ast_error(token, "Cannot use void function \"%s\" in expression\n", lexer_token_value(lexer, token));
                 }
-            }
-        }
-        if (has_unary) {
-            return expression;
-        } else {
-            node_error(expression, "Expected unary operator in expression of length 2");
-        }
-    } else if (expression->num_children == 3) {
-        bool has_binary = false;
-        for (size_t i = 0; i < expression->num_children; i++) {
-            Node* child = expression->children[i];
-            if (child->type == NODE_OPERATOR) {
-                for (size_t j = 0; j < array_length(binary_precedence); j++) {
-                    if (strcmp(child->data, binary_precedence[j]) == 0) {
-                        has_binary = true;
+                Node* call_exp = ast_parse_call_expression(lexer);
+                lexer_advance_cursor(lexer, 1);
+                return call_exp;
+            } else if (next_tok->type == TOKEN_PUNCTUATION && next_tok->punctuation == PUNCTUATION_LBRACKET) {
+                lexer_advance_cursor(lexer, 1);
+                Node* array_element = create_node(NODE_ARRAY_ELEMENT, lexer_token_value(lexer, token), token->line, token->column);
+                while (true) {
+                    Node* array_index = ast_parse_array_index(lexer);
+                    node_add_child(array_element, array_index);
+                    Token* tok = lexer_peek_token(lexer, 0);
+                    if (tok->type != TOKEN_PUNCTUATION || tok->punctuation != PUNCTUATION_LBRACKET) {
                         break;
                     }
                 }
+                return array_element;
+            } else if (next_tok->type == TOKEN_OPERATOR && next_tok->op == OPERATOR_DOT) {
+                Node* struct_access = ast_parse_struct_access(lexer);
+                lexer_advance_cursor(lexer, 1);
+                return struct_access;
             }
+            lexer_advance_cursor(lexer, 1);
+            return create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
         }
-        if (has_binary) {
-            return expression;
-        } else {
-            node_error(expression, "Expected binary operator in expression of length 3");
-        }
-    } else {
-        // Deal with all the unary operators first
-        for (size_t i = 0; i < expression->num_children; i++) {
-            Node* child = expression->children[i];
-            Node* next_child = expression->children[i + 1];
-
-            if (i == 0 && child->type == NODE_OPERATOR) {
-                if (next_child->type == NODE_OPERATOR) {
-                    node_error(expression, "Two operators in a row at the beginning of expression");
-                } else {
-                    for (size_t j = 0; j < array_length(unary_precedence); j++) {
-                        if (strcmp(child->data, unary_precedence[j]) == 0) {
-                            Node* new_expression = create_node(NODE_EXPRESSION, NULL, child->line, child->column);
-                            node_add_child(new_expression, child);
-                            node_add_child(new_expression, next_child);
-                            expression->children[i] = new_expression;
-                            for (size_t k = i + 1; k < expression->num_children; k++) {
-                                expression->children[k] = expression->children[k + 1];
-                            }
-                            expression->num_children--;
-                        }
-                    }
-                }
+        case TOKEN_STRING:
+            lexer_advance_cursor(lexer, 1);
+            return create_node(NODE_STRING_LITERAL, lexer_token_value(lexer, token), token->line, token->column);
+        case TOKEN_NUMBER:
+            lexer_advance_cursor(lexer, 1);
+            return ast_create_literal(lexer, NODE_NUMERIC_LITERAL, token);
+        case TOKEN_FLOAT_NUM:
+            lexer_advance_cursor(lexer, 1);
+            return ast_create_literal(lexer, NODE_FLOAT_LITERAL, token);
+        case TOKEN_KEYWORD: {
+            NodeType type;
+            if (token->keyword == KEYWORD_TRUE) {
+                type = NODE_TRUE_LITERAL;
+            } else if (token->keyword == KEYWORD_FALSE) {
+                type = NODE_FALSE_LITERAL;
+            } else if (token->keyword == KEYWORD_NULL) {
+                type = NODE_NULL_LITERAL;
             } else {
-                if (child->type == NODE_OPERATOR && next_child->type == NODE_OPERATOR) {
-                    for (size_t j = 0; j < array_length(unary_precedence); j++) {
-                        if (strcmp(child->data, unary_precedence[j]) == 0) {
-                            Node* new_expression = create_node(NODE_EXPRESSION, NULL, child->line, child->column);
-                            node_add_child(new_expression, next_child);
-                            node_add_child(new_expression, expression->children[i + 2]);
-
-                            expression->children[i + 1] = new_expression;
-                            for (size_t k = i + 2; k < expression->num_children; k++) {
-                                expression->children[k] = expression->children[k + 1];
-                            }
-                            expression->num_children--;
-                        }
-                    }
-                }
+                ast_error(token, "Unexpected keyword in expression: %s\n", lexer_token_value(lexer, token));
             }
+            lexer_advance_cursor(lexer, 1);
+            return create_node(type, lexer_token_value(lexer, token), token->line, token->column);
         }
-        // expression->num_children > 3
-        // We need to find the lowest precedence operator
-        // and split the expression into two expressions
-        // at that operator
-        size_t lowest_precedence = 100;
-        size_t lowest_precedence_idx = 0;
-        bool found_operator = false;
-        for (size_t i = 0; i < expression->num_children; i++) {
-            Node* child = expression->children[i];
-            if (child->type == NODE_OPERATOR) {
-                for (size_t j = 0; j < array_length(binary_precedence); j++) {
-                    if (strcmp(child->data, binary_precedence[j]) == 0) {
-                        if (j < lowest_precedence) {
-                            lowest_precedence = j;
-                            lowest_precedence_idx = i;
-                            found_operator = true;
-                        }
-                        break;
-                    }
+        case TOKEN_OPERATOR: {
+            if (!unary_operators[token->op]) {
+                ast_error(token, "Expected unary operator in expression, got %s\n", lexer_token_value(lexer, token));
+            }
+            Node* unary = create_node(NODE_EXPRESSION, NULL, token->line, token->column);
+            Node* operator= create_node(NODE_OPERATOR, lexer_token_value(lexer, token), token->line, token->column);
+            operator->op = token->op;
+            lexer_advance_cursor(lexer, 1);
+            node_add_child(unary, operator);
+            node_add_child(unary, ast_parse_operand(lexer));
+            return unary;
+        }
+        case TOKEN_PUNCTUATION:
+            if (token->punctuation == PUNCTUATION_LPAREN) {
+                lexer_advance_cursor(lexer, 1);
+                Node* paren_expression = ast_parse_binary_expression(lexer, 0);
+                token = ast_expression_peek(lexer);
+                if (token->type != TOKEN_PUNCTUATION || token->punctuation != PUNCTUATION_RPAREN) {
+                    ast_error(token, "Expected closing parenthesis in expression, got %s\n", lexer_token_value(lexer, token));
                 }
+                lexer_advance_cursor(lexer, 1);
+                return paren_expression;
             }
+            ast_error(token, "Unexpected punctuation in expression: %s\n", lexer_token_value(lexer, token));
+            break;
+        default:
+            break;
+    }
+    ast_error(token, "Unexpected token in expression: %s\n", lexer_token_value(lexer, token));
+    return NULL;
+}
+
+// Precedence climbing: folds operators binding tighter than min_precedence
+// into [lhs, operator, rhs] expressions, in one pass over the tokens
+static Node* ast_parse_binary_expression(Lexer* lexer, uint8_t min_precedence) {
+    Node* lhs = ast_parse_operand(lexer);
+    while (true) {
+        Token* token = ast_expression_peek(lexer);
+        if (token->type != TOKEN_OPERATOR) {
+            return lhs;
         }
-        if (!found_operator) {
-            node_error(expression, "Expected binary operator in expression of length > 3");
+        uint8_t precedence = binary_precedence[token->op];
+        if (precedence == 0) {
+            ast_error(token, "Expected binary operator in expression, got %s\n", lexer_token_value(lexer, token));
         }
-        Node* left_expression = create_node(NODE_EXPRESSION, NULL, 0, 0);
-        Node* right_expression = create_node(NODE_EXPRESSION, NULL, 0, 0);
-        for (size_t i = 0; i < expression->num_children; i++) {
-            Node* child = expression->children[i];
-            if (i < lowest_precedence_idx) {
-                left_expression->line = child->line;
-                left_expression->column = child->column;
-                node_add_child(left_expression, child);
-            } else if (i > lowest_precedence_idx) {
-                right_expression->line = child->line;
-                right_expression->column = child->column;
-                node_add_child(right_expression, child);
-            }
+        if (precedence <= min_precedence) {
+            return lhs;
         }
-        Node* operator= expression->children[lowest_precedence_idx];
-        Node* new_expression = create_node(NODE_EXPRESSION, NULL, expression->line, expression->column);
-        node_add_child(new_expression, ast_expression_descent(left_expression));
-        node_add_child(new_expression, operator);
-        node_add_child(new_expression, ast_expression_descent(right_expression));
-        return new_expression;
-    }
-    fprintf(stderr, "Error: Unreachable code\n");
-    exit(1);
-    return NULL;
+        Node* operator= create_node(NODE_OPERATOR, lexer_token_value(lexer, token), token->line, token->column);
+        operator->op = token->op;
+        lexer_advance_cursor(lexer, 1);
+        Node* rhs = ast_parse_binary_expression(lexer, binary_right_associative[token->op] ? precedence - 1 : precedence);
+
+        Node* binary = create_node(NODE_EXPRESSION, NULL, lhs->line, lhs->column);
+        node_add_child(binary, lhs);
+        node_add_child(binary, operator);
+        node_add_child(binary, rhs);
+        lhs = binary;
+    }
 }
 
+// Always returns a NODE_EXPRESSION, wrapping a lone operand. A trailing comma
+// or semicolon is consumed, a closing bracket, parenthesis or an opening
+// brace is left for the caller.
 Node* ast_parse_expression(Lexer* lexer) {
-    Node* expression = ast_parse_expression_flat(lexer);
-    Node* new_expression = ast_expression_descent(expression);
-    return new_expression;
+    Token* token = ast_expression_peek(lexer);
+    Node* expression = ast_parse_binary_expression(lexer, 0);
+    if (expression->type != NODE_EXPRESSION) {
+        Node* operand = expression;
+        expression = create_node(NODE_EXPRESSION, NULL, token->line, token->column);
+        node_add_child(expression, operand);
+    }
+
+    token = ast_expression_peek(lexer);
+    if (token->type == TOKEN_PUNCTUATION) {
+        switch (token->punctuation) {
+            case PUNCTUATION_COMMA:
+            case PUNCTUATION_SEMICOLON:
+                lexer_advance_cursor(lexer, 1);
+                return expression;
+            case PUNCTUATION_RPAREN:
+            case PUNCTUATION_RBRACKET:
+            case PUNCTUATION_LBRACE:
+                return expression;
+            default:
+                break;
+        }
+    }
+    ast_error(token, "Unexpected token in expression: %s\n", lexer_token_value(lexer, token));
+    return NULL;
 }
 
 Node* ast_parse_array_index(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     Node* array_index = create_node(NODE_EXPRESSION, NULL, token->line, token->column);
-    if (token->type != TOKEN_PUNCTUATION && strcmp(token->value, "[") != 0) {
-        ast_error(token, "Expected opening bracket in array index, got %s\n", token->value);
+    if (token->punctuation != PUNCTUATION_LBRACKET) {
+        ast_error(token, "Expected opening bracket in array index, got %s\n", lexer_token_value(lexer, token));
     }
     lexer_advance_cursor(lexer, 1);
     while (true) {
         token = lexer_peek_token(lexer, 0);
-        if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, "]") == 0) {
+        if (token->punctuation == PUNCTUATION_RBRACKET) {
             lexer_advance_cursor(lexer, 1);
             break;
         } else if (token->type == TOKEN_IDENTIFIER) {
-            Node* identifier = create_node(NODE_IDENTIFIER, token->value, token->line, token->column);
+            Node* identifier = create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
             node_add_child(array_index, identifier);
         } else if (token->type == TOKEN_NUMBER) {
-            Node* numeric_literal = create_node(NODE_NUMERIC_LITERAL, token->value, token->line, token->column);
+            Node* numeric_literal = ast_create_literal(lexer, NODE_NUMERIC_LITERAL, token);
             node_add_child(array_index, numeric_literal);
         } else if (token->type == TOKEN_OPERATOR) {
-            Node* operator= create_node(NODE_OPERATOR, token->value, token->line, token->column);
+            Node* operator= create_node(NODE_OPERATOR, lexer_token_value(lexer, token), token->line, token->column);
+            operator->op = token->op;
             node_add_child(array_index, operator);
-        } else if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, "[") == 0) {
+        } else if (token->punctuation == PUNCTUATION_LBRACKET) {
             Node* array_index_child = ast_parse_array_index(lexer);
             node_add_child(array_index, array_index_child);
         } else {
-            ast_error(token, "Unexpected token in array index: %s\n", token->value);
+            ast_error(token, "Unexpected token in array index: %s\n", lexer_token_value(lexer, token));
         }
         lexer_advance_cursor(lexer, 1);
     }
@@ -1158,28 +1310,25 @@ Node* ast_parse_call_expression(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
 
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier as left-hand side of call expression, got %s\n", token->value);
+        ast_error(token, "Expected identifier as left-hand side of call expression, got %s\n", lexer_token_value(lexer, token));
     }
 
-    for (size_t i = 0; i < ast_data->function_count; i++) {
-        if (strcmp(ast_data->functions[i]->name, token->value) == 0) {
-            break;
-        } else if (i == ast_data->function_count - 1) {
-            ast_error(token, "Cannot call undeclared function %s\n", token->value);
-        }
+    if (ast_data->function_count > 0 && ast_data_find_function(ast_data, token->id) == NULL) {
+        ast_error(token, "Cannot call undeclared function %s\n", lexer_token_value(lexer, token));
     }
 
     Node* call_expression = create_node(NODE_CALL_EXPRESSION, NULL, token->line, token->column);
-    Node* identifier = create_node(NODE_IDENTIFIER, token->value, token->line, token->column);
+    Node* identifier = create_node(NODE_IDENTIFIER, lexer_token_value(lexer, token), token->line, token->column);
     node_add_child(call_expression, identifier);
     token = lexer_peek_token(lexer, 1);
-    if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, "(") != 0) {
-        ast_error(token, "Expected opening parenthesis after identifier in call expression, got %s\n", token->value);
+    if (token->punctuation != PUNCTUATION_LPAREN) {
+        ast_error(token, "Expected opening parenthesis after identifier in call expression, got %s\n",
+                  lexer_token_value(lexer, token));
     }
     lexer_advance_cursor(lexer, 2);
     while (true) {
         token = lexer_peek_token(lexer, 0);
-        if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, ")") == 0) {
+        if (token->punctuation == PUNCTUATION_RPAREN) {
             break;
         }
         Node* argument = ast_parse_expression(lexer);
@@ -1190,58 +1339,60 @@ Node* ast_parse_call_expression(Lexer* lexer) {
         }
     }
     token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, ")") != 0) {
-        ast_error(token, "Expected closing parenthesis after call expression, got %s\n", token->value);
+    if (token->punctuation != PUNCTUATION_RPAREN) {
+        ast_error(token, "Expected closing parenthesis after call expression, got %s\n", lexer_token_value(lexer, token));
     }
     return call_expression;
 }
 
 Node* ast_parse_struct_declaration(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_KEYWORD || get_keyword_type(token->value) != KEYWORD_STRUCT) {
-        ast_error(token, "Expected struct keyword in struct declaration, got %s\n", token->value);
+    if (token->type != TOKEN_KEYWORD || token->keyword != KEYWORD_STRUCT) {
+        ast_error(token, "Expected struct keyword in struct declaration, got %s\n", lexer_token_value(lexer, token));
     }
     lexer_advance_cursor(lexer, 1);
     token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_TYPEDECLARATION) {
-        ast_error(token, "Expected identifier after struct keyword in struct declaration, got %s\n", token->value);
+        ast_error(token, "Expected identifier after struct keyword in struct declaration, got %s\n",
+                  lexer_token_value(lexer, token));
     }
-    Node* struct_declaration = create_node(NODE_STRUCT_DECLARATION, token->value, token->line, token->column);
+    Node* struct_declaration = create_node(NODE_STRUCT_DECLARATION, lexer_token_value(lexer, token), token->line, token->column);
 
-    Struct* strct = ast_data_struct_create(token->value);
+    Struct* strct = ast_data_struct_create(lexer_token_value(lexer, token));
 
     lexer_advance_cursor(lexer, 1);
     token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, "{") != 0) {
-        ast_error(token, "Expected opening curly brace after struct identifier in struct declaration, got %s\n", token->value);
+    if (token->punctuation != PUNCTUATION_LBRACE) {
+        ast_error(token, "Expected opening curly brace after struct identifier in struct declaration, got %s\n",
+                  lexer_token_value(lexer, token));
     }
     lexer_advance_cursor(lexer, 1);
     while (true) {
         token = lexer_peek_token(lexer, 0);
-        if (token->type == TOKEN_PUNCTUATION && strcmp(token->value, "}") == 0) {
+        if (token->punctuation == PUNCTUATION_RBRACE) {
             lexer_advance_cursor(lexer, 1);
             break;
         }
         if (token->type != TOKEN_IDENTIFIER) {
-            ast_error(token, "Expected identifier as member of struct, got %s\n", token->value);
+            ast_error(token, "Expected identifier as member of struct, got %s\n", lexer_token_value(lexer, token));
         }
-        Node* member = create_node(NODE_STRUCT_MEMBER, token->value, token->line, token->column);
+        Node* member = create_node(NODE_STRUCT_MEMBER, lexer_token_value(lexer, token), token->line, token->column);
         lexer_advance_cursor(lexer, 1);
         token = lexer_peek_token(lexer, 0);
-        if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, ":") != 0) {
-            ast_error(token, "Expected colon after identifier in struct member, got %s\n", token->value);
+        if (token->punctuation != PUNCTUATION_COLON) {
+            ast_error(token, "Expected colon after identifier in struct member, got %s\n", lexer_token_value(lexer, token));
         }
         lexer_advance_cursor(lexer, 1);
         token = lexer_peek_token(lexer, 0);
         if (token->type != TOKEN_TYPEANNOTATION) {
-            ast_error(token, "Expected type after identifier in struct member, got %s\n", token->value);
+            ast_error(token, "Expected type after identifier in struct member, got %s\n", lexer_token_value(lexer, token));
         }
-        Node* type = create_node(NODE_TYPE, token->value, token->line, token->column);
+        Node* type = create_node(NODE_TYPE, lexer_token_value(lexer, token), token->line, token->column);
         node_add_child(member, type);
         lexer_advance_cursor(lexer, 1);
         token = lexer_peek_token(lexer, 0);
-        if (token->type != TOKEN_PUNCTUATION || strcmp(token->value, ",") != 0) {
-            ast_error(token, "Expected semicolon after type in struct member, got %s\n", token->value);
+        if (token->punctuation != PUNCTUATION_COMMA) {
+            ast_error(token, "Expected semicolon after type in struct member, got %s\n", lexer_token_value(lexer, token));
         }
         node_add_child(struct_declaration, member);
         lexer_advance_cursor(lexer, 1);
@@ -1253,52 +1404,34 @@ Node* ast_parse_struct_declaration(Lexer* lexer) {
     return struct_declaration;
 }
 
+// Struct type of the variable or pointer named name_id, NULL if there is none
+static Struct* ast_find_variable_struct(uint32_t name_id) {
+    Variable* variable = ast_data_find_variable(ast_data, name_id);
+    if (variable != NULL) {
+        return ast_data_find_struct(ast_data, variable->type->name_id);
+    }
+    Pointer* pointer = ast_data_find_pointer(ast_data, name_id);
+    if (pointer != NULL) {
+        return ast_data_find_struct(ast_data, pointer->base_type->name_id);
+    }
+    return NULL;
+}
+
 Node* ast_parse_struct_access(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier as left-hand side of struct access, got %s\n", token->value);
-    }
-    bool found_struct = false;
-    size_t struct_idx = 0;
-    for (size_t i = 0; i < ast_data->variable_count; i++) {
-        if (strcmp(ast_data->variables[i]->name, token->value) == 0) {
-            found_struct = true;
-            DataType* type = ast_data->variables[i]->type;
-            for (size_t j = 0; j < ast_data->struct_count; j++) {
-                if (strcmp(ast_data->structs[j]->name, type->name) == 0) {
-                    struct_idx = j;
-                    break;
-                }
-            }
-            break;
-        }
+        ast_error(token, "Expected identifier as left-hand side of struct access, got %s\n", lexer_token_value(lexer, token));
     }
-
-    if (!found_struct) {
-        for (size_t i = 0; i < ast_data->pointer_count; i++) {
-            if (strcmp(ast_data->pointers[i]->name, token->value) == 0) {
-                found_struct = true;
-                DataType* type = ast_data->pointers[i]->base_type;
-                for (size_t j = 0; j < ast_data->struct_count; j++) {
-                    if (strcmp(ast_data->structs[j]->name, type->name) == 0) {
-                        struct_idx = j;
-                        break;
-                    }
-                }
-                break;
-            }
-        }
+    Struct* strct = ast_find_variable_struct(token->id);
+    if (strct == NULL) {
+        ast_error(token, "Cannot access an undeclared struct %s\n", lexer_token_value(lexer, token));
     }
 
-    if (!found_struct) {
-        ast_error(token, "Cannot access an undeclared struct %s\n", token->value);
-    }
-
-    Node* struct_access = create_node(NODE_STRUCT_ACCESS, token->value, token->line, token->column);
+    Node* struct_access = create_node(NODE_STRUCT_ACCESS, lexer_token_value(lexer, token), token->line, token->column);
     lexer_advance_cursor(lexer, 1);
     token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_OPERATOR || strcmp(token->value, ".") != 0) {
-        ast_error(token, "Expected dot operator after identifier in struct access, got %s\n", token->value);
+    if (token->op != OPERATOR_DOT) {
+        ast_error(token, "Expected dot operator after identifier in struct access, got %s\n", lexer_token_value(lexer, token));
     }
     lexer_advance_cursor(lexer, 1);
     
@@ -1306,24 +1439,23 @@ Node* ast_parse_struct_access(Lexer* lexer) {
     while(true) {
         token = lexer_peek_token(lexer, 0);
         if (token->type != TOKEN_IDENTIFIER) {
-            ast_error(token, "Expected identifier after dot operator in struct access, got %s\n", token->value);
+            ast_error(token, "Expected identifier after dot operator in struct access, got %s\n", lexer_token_value(lexer, token));
         }
 
         bool found_member = false;
         size_t member_idx = 0;
-        for (size_t i = 0; i < ast_data->structs[struct_idx]->member_count; i++) {
-            const char* member_name = ast_data->structs[struct_idx]->members[i].name;
-            if (strcmp(member_name, token->value) == 0) {
+        for (size_t i = 0; i < strct->member_count; i++) {
+            if (strct->members[i].name_id == token->id) {
                 found_member = true;
                 member_idx = i;
                 break;
             }
         }
         if (!found_member) {
-            ast_error(token, "Cannot assign to undeclared member %s in struct %s\n", token->value, ast_data->structs[struct_idx]->name);
+            ast_error(token, "Cannot assign to undeclared member %s in struct %s\n", lexer_token_value(lexer, token), strct->name);
         }
 
-        Node* member = create_node(NODE_STRUCT_MEMBER, token->value, token->line, token->column);
+        Node* member = create_node(NODE_STRUCT_MEMBER, lexer_token_value(lexer, token), token->line, token->column);
         if (prev_node != NULL) {
             node_add_child(prev_node, member);
             prev_node = member;
@@ -1333,25 +1465,18 @@ Node* ast_parse_struct_access(Lexer* lexer) {
         }
 
         Token* next_token = lexer_peek_token(lexer, 1);
-        if (next_token->type != TOKEN_OPERATOR || strcmp(next_token->value, ".") != 0) {
+        if (next_token->op != OPERATOR_DOT) {
             break;
         }
         lexer_advance_cursor(lexer, 2);
 
-        bool found_struct = false;
         // Check if the member is a struct
-        for (size_t i = 0; i < ast_data->struct_count; i++) {
-            const char* member_type = ast_data->structs[struct_idx]->members[member_idx].type->name;
-            const char* current_struct = ast_data->structs[i]->name;
-            if (strcmp(current_struct, member_type) == 0) {
-                struct_idx = i;
-                found_struct = true;
-                break;
-            }
-        }
-        if (!found_struct) {
-            ast_error(token, "Cannot access member %s in struct %s, it is not a struct\n", token->value, ast_data->structs[struct_idx]->name);
+        Struct* member_struct = ast_data_find_struct(ast_data, strct->members[member_idx].type->name_id);
+        if (member_struct == NULL) {
+            ast_error(token, "Cannot access member %s in struct %s, it is not a struct\n",
+                      lexer_token_value(lexer, token), strct->name);
         }
+        strct = member_struct;
     }
     return struct_access;
 }
@@ -1359,95 +1484,70 @@ Node* ast_parse_struct_access(Lexer* lexer) {
 Node* ast_parse_struct_member_assignment(Lexer* lexer) {
     Token* token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier as left-hand side of struct member assignment, got %s\n", token->value);
+        ast_error(token, "Expected identifier as left-hand side of struct member assignment, got %s\n",
+                  lexer_token_value(lexer, token));
     }
     
-    bool found_struct = false;
-    size_t struct_idx = 0;
-    for (size_t i = 0; i < ast_data->variable_count; i++) {
-        if (strcmp(ast_data->variables[i]->name, token->value) == 0) {
-            found_struct = true;
-            DataType* type = ast_data->variables[i]->type;
-            for (size_t j = 0; j < ast_data->struct_count; j++) {
-                if (strcmp(ast_data->structs[j]->name, type->name) == 0) {
-                    struct_idx = j;
-                    break;
-                }
-            }
-            break;
-        }
-    }
-
-    if (!found_struct) {
-        for (size_t i = 0; i < ast_data->pointer_count; i++) {
-            if (strcmp(ast_data->pointers[i]->name, token->value) == 0) {
-                found_struct = true;
-                DataType* type = ast_data->pointers[i]->base_type;
-                for (size_t j = 0; j < ast_data->struct_count; j++) {
-                    if (strcmp(ast_data->structs[j]->name, type->name) == 0) {
-                        struct_idx = j;
-                        break;
-                    }
-                }
-                break;
-            }
-        }
-    }
-
-    if (!found_struct) {
-        ast_error(token, "Cannot assign to undeclared struct %s\n", token->value);
+    Struct* strct = ast_find_variable_struct(token->id);
+    if (strct == NULL) {
+        ast_error(token, "Cannot assign to undeclared struct %s\n", lexer_token_value(lexer, token));
     }
 
     Node* struct_member_assignment = create_node(NODE_STRUCT_MEMBER_ASSIGNMENT, NULL, token->line, token->column);
-    Node* struct_access = create_node(NODE_STRUCT_ACCESS, token->value, token->line, token->column);
+    Node* struct_access = create_node(NODE_STRUCT_ACCESS, lexer_token_value(lexer, token), token->line, token->column);
     lexer_advance_cursor(lexer, 1);
     token = lexer_peek_token(lexer, 0);
-    if (token->type != TOKEN_OPERATOR || strcmp(token->value, ".") != 0) {
-        ast_error(token, "Expected dot operator after identifier in struct member assignment, got %s\n", token->value);
+    if (token->op != OPERATOR_DOT) {
+        ast_error(token, "Expected dot operator after identifier in struct member assignment, got %s\n",
+                  lexer_token_value(lexer, token));
     }
     lexer_advance_cursor(lexer, 1);
     token = lexer_peek_token(lexer, 0);
     if (token->type != TOKEN_IDENTIFIER) {
-        ast_error(token, "Expected identifier after dot operator in struct member assignment, got %s\n", token->value);
+        ast_error(token, "Expected identifier after dot operator in struct member assignment, got %s\n",
+                  lexer_token_value(lexer, token));
     }
 
     bool found_member = false;
-    for (size_t i = 0; i < ast_data->structs[struct_idx]->member_count; i++) {
-        if (strcmp(ast_data->structs[struct_idx]->members[i].name, token->value) == 0) {
+    for (size_t i = 0; i < strct->member_count; i++) {
+        if (strct->members[i].name_id == token->id) {
             found_member = true;
             break;
         }
     }
     if (!found_member) {
-        ast_error(token, "Cannot assign to undeclared member %s in struct %s\n", token->value, ast_data->structs[struct_idx]->name);
+        ast_error(token, "Cannot assign to undeclared member %s in struct %s\n", lexer_token_value(lexer, token), strct->name);
     }
 
-    Node* member = create_node(NODE_STRUCT_MEMBER, token->value, token->line, token->column);
+    Node* member = create_node(NODE_STRUCT_MEMBER, lexer_token_value(lexer, token), token->line, token->column);
     node_add_child(struct_access, member);
     node_add_child(struct_member_assignment, struct_access);
     lexer_advance_cursor(lexer, 1);
     while (true) {
         token = lexer_peek_token(lexer, 0);
         if (token->type != TOKEN_OPERATOR) {
-            ast_error(token, "Expected assignment operator or sub-struct member assignment after struct member access in struct member assignment, got %s\n", token->value);
+            ast_error(token, "Expected assignment operator or sub-struct member assignment after struct member access in struct member assignment, got %s\n",
+                      lexer_token_value(lexer, token));
         }
-        if (strcmp(token->value, "=") == 0) {
+        if (token->op == OPERATOR_ASSIGN) {
             lexer_advance_cursor(lexer, 1);
             Node* expression = ast_parse_expression(lexer);
             node_add_child(struct_member_assignment, expression);
             break;
-        } else if (strcmp(token->value, ".") == 0) {
+        } else if (token->op == OPERATOR_DOT) {
             lexer_advance_cursor(lexer, 1);
             token = lexer_peek_token(lexer, 0);
             if (token->type != TOKEN_IDENTIFIER) {
-                ast_error(token, "Expected identifier after dot operator in struct member assignment, got %s\n", token->value);
+                ast_error(token, "Expected identifier after dot operator in struct member assignment, got %s\n",
+                          lexer_token_value(lexer, token));
             }
-            Node* sub_member = create_node(NODE_STRUCT_MEMBER, token->value, token->line, token->column);
+            Node* sub_member = create_node(NODE_STRUCT_MEMBER, lexer_token_value(lexer, token), token->line, token->column);
             node_add_child(member, sub_member);
             member = sub_member;
             lexer_advance_cursor(lexer, 1);
         } else {
-            ast_error(token, "Expected assignment operator or sub-struct member assignment after struct member access in struct member assignment, got %s\n", token->value);
+            ast_error(token, "Expected assignment operator or sub-struct member assignment after struct member access in struct member assignment, got %s\n",
+                      lexer_token_value(lexer, token));
         }
     }
     return struct_member_assignment;
@@ -0,0 +1,276 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "ast.h"
+#include "codegen.h"
+#include "lexer.h"
+#include "session.h"
+#include "utils/scan.h"
+#include "utils/thread.h"
+
+#ifdef _WIN32
+#define BENCH_NULL_OUTPUT "NUL"
+#else
+#define BENCH_NULL_OUTPUT "/dev/null"
+#endif
+
+// Nesting depth of the bodies in the nesting corpus is its count, spread over
+// this many functions
+#define BENCH_NESTING_FUNCTIONS 16
+// Terms in each expression of the expressions corpus
+#define BENCH_EXPRESSION_TERMS 32
+#define BENCH_DEFAULT_STRUCTS 2000
+
+typedef void (*BenchGenerator)(FILE *file, size_t count);
+
+typedef struct BenchCorpus {
+    const char *name;
+    BenchGenerator generate;
+    size_t default_count;
+} BenchCorpus;
+
+static double bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Functions shaped like the loops in examples/, one after another
+static void bench_generate_functions(FILE *file, size_t count) {
+    fprintf(file, "fnc print(a : str, ...) : void;\n\n");
+    for (size_t i = 0; i < count; i++) {
+        fprintf(file, "fnc work%zu(a : i32, b : i32) : i32 {\n", i);
+        fprintf(file, "    c : i32 = a + b * %zu;\n", i);
+        fprintf(file, "    d : i32 = 0;\n");
+        fprintf(file, "    arr : [i32; 8];\n");
+        fprintf(file, "    while (d < c) {\n");
+        fprintf(file, "        if (d %% 2 == 0) {\n");
+        fprintf(file, "            c = c - 1;\n");
+        fprintf(file, "        } elif (d %% 3 == 0) {\n");
+        fprintf(file, "            arr[d %% 8] = d;\n");
+        fprintf(file, "        } else {\n");
+        fprintf(file, "            print(\"%%d\\n\", d);\n");
+        fprintf(file, "        }\n");
+        fprintf(file, "        d = d + 1;\n");
+        fprintf(file, "    }\n");
+        fprintf(file, "    ret c;\n");
+        fprintf(file, "}\n\n");
+    }
+}
+
+// Alternating while and if blocks, count levels deep. Indentation stops
+// growing after a while so that the corpus is not mostly spaces.
+static void bench_generate_nesting(FILE *file, size_t count) {
+    for (size_t f = 0; f < BENCH_NESTING_FUNCTIONS; f++) {
+        fprintf(file, "fnc nest%zu(a : i32) : i32 {\n", f);
+        fprintf(file, "    v0 : i32 = a;\n");
+        for (size_t depth = 1; depth <= count; depth++) {
+            int indent = (depth < 16 ? (int)depth : 16) * 4;
+            if (depth % 2 == 1) {
+                fprintf(file, "%*swhile (v%zu > 0) {\n", indent, "", depth - 1);
+                fprintf(file, "%*s    v%zu = v%zu - 1;\n", indent, "", depth - 1, depth - 1);
+            } else {
+                fprintf(file, "%*sif (v%zu %% 2 == 0) {\n", indent, "", depth - 1);
+            }
+            fprintf(file, "%*s    v%zu : i32 = v%zu + %zu;\n", indent, "", depth, depth - 1, depth);
+        }
+        for (size_t depth = count; depth >= 1; depth--) {
+            fprintf(file, "%*s}\n", (depth < 16 ? (int)depth : 16) * 4, "");
+        }
+        fprintf(file, "    ret v0;\n");
+        fprintf(file, "}\n\n");
+    }
+}
+
+// Functions returning one long expression mixing precedence levels
+static void bench_generate_expressions(FILE *file, size_t count) {
+    static const char *operators[] = {"+", "-", "*", "/", "%"};
+    for (size_t i = 0; i < count; i++) {
+        fprintf(file, "fnc expr%zu(a : i32, b : i32) : i32 {\n", i);
+        fprintf(file, "    c : i32 = a");
+        for (size_t term = 1; term < BENCH_EXPRESSION_TERMS; term++) {
+            const char *op = operators[(i + term) % 5];
+            if (term % 2 == 0) {
+                fprintf(file, " %s b", op);
+            } else {
+                fprintf(file, " %s %zu", op, term + 1);
+            }
+        }
+        fprintf(file, ";\n");
+        fprintf(file, "    if (c > a && c != b || a == 0) {\n");
+        fprintf(file, "        c = -c;\n");
+        fprintf(file, "    }\n");
+        fprintf(file, "    ret c;\n");
+        fprintf(file, "}\n\n");
+    }
+}
+
+// Structs that each embed the previous one, and a function filling each
+static void bench_generate_structs(FILE *file, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        fprintf(file, "struct rec%zu {\n", i);
+        fprintf(file, "    id: i32,\n");
+        fprintf(file, "    name: str,\n");
+        fprintf(file, "    total: i64,\n");
+        if (i > 0) {
+            fprintf(file, "    inner: rec%zu,\n", i - 1);
+        }
+        fprintf(file, "};\n\n");
+    }
+    for (size_t i = 0; i < count; i++) {
+        fprintf(file, "fnc fill%zu(a : i32) : i32 {\n", i);
+        fprintf(file, "    r%zu : rec%zu;\n", i, i);
+        fprintf(file, "    r%zu.id = a;\n", i);
+        fprintf(file, "    r%zu.name = \"rec%zu\";\n", i, i);
+        if (i > 0) {
+            fprintf(file, "    r%zu.inner.id = a + 1;\n", i);
+            fprintf(file, "    t%zu : i32 = r%zu.inner.id + a;\n", i, i);
+        } else {
+            fprintf(file, "    t%zu : i32 = r%zu.id + a;\n", i, i);
+        }
+        fprintf(file, "    ret t%zu;\n", i);
+        fprintf(file, "}\n\n");
+    }
+}
+
+static const BenchCorpus corpora[] = {
+    {"functions", bench_generate_functions, 2000},
+    {"nesting", bench_generate_nesting, 200},
+    {"expressions", bench_generate_expressions, 2000},
+    {"structs", bench_generate_structs, BENCH_DEFAULT_STRUCTS},
+};
+
+bool bench_generate(const char *kind, size_t count, const char *output) {
+    for (size_t i = 0; i < sizeof(corpora) / sizeof(corpora[0]); i++) {
+        if (strcmp(kind, corpora[i].name) != 0) {
+            continue;
+        }
+        FILE *file = fopen(output, "w");
+        if (file == NULL) {
+            fprintf(stderr, "Error: Could not open %s\n", output);
+            return false;
+        }
+        corpora[i].generate(file, count);
+        fclose(file);
+        return true;
+    }
+    fprintf(stderr, "Error: Unknown corpus %s, expected functions, nesting, expressions or structs\n", kind);
+    return false;
+}
+
+static size_t bench_count_nodes(Node *node) {
+    size_t count = 1;
+    for (size_t i = 0; i < node->num_children; i++) {
+        count += bench_count_nodes(node->children[i]);
+    }
+    return count;
+}
+
+static size_t bench_peak_rss_kb() {
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+typedef struct BenchPhase {
+    double best;
+    double total;
+} BenchPhase;
+
+static void bench_record(BenchPhase *phase, size_t iteration, double elapsed) {
+    phase->total += elapsed;
+    if (iteration == 0 || elapsed < phase->best) {
+        phase->best = elapsed;
+    }
+}
+
+void bench_file(char *filename, size_t iterations) {
+    CompilerOptions options = {.keep_comments = false, .emit = CODEGEN_OUTPUT_IR};
+    size_t size = 0;
+    size_t token_count = 0;
+    size_t node_count = 0;
+    BenchPhase lex = {0};
+    BenchPhase parse = {0};
+    BenchPhase parallel = {0};
+    BenchPhase codegen = {0};
+    BenchPhase write = {0};
+    size_t threads = thread_hardware_count();
+    for (size_t i = 0; i < iterations; i++) {
+        CompilerSession *session = compiler_session_create(filename, &options);
+        double start = bench_now();
+        Lexer *lexer = lexer_create(filename);
+        if (lexer == NULL) {
+            compiler_session_destroy(session);
+            return;
+        }
+        session->lexer = lexer;
+        lexer_lexall(lexer, false);
+        bench_record(&lex, i, bench_now() - start);
+        size = lexer->size;
+        token_count = lexer->token_count;
+
+        session->ast = ast_create();
+        lexer_set_cursor(lexer, 0);
+        start = bench_now();
+        session->ast->root = ast_parse_program(lexer);
+        bench_record(&parse, i, bench_now() - start);
+        node_count = bench_count_nodes(session->ast->root);
+
+        start = bench_now();
+        LLVMModuleRef module = ast_to_module(session->ast, lexer->filename, false);
+        bench_record(&codegen, i, bench_now() - start);
+        start = bench_now();
+        codegen_write_ir(module, BENCH_NULL_OUTPUT);
+        bench_record(&write, i, bench_now() - start);
+        codegen_destroy_module(module);
+        compiler_session_destroy(session);
+
+        // Again with function bodies spread over every core. The parser
+        // relabels tokens as it goes, so this needs a freshly lexed copy.
+        CompilerSession *parallel_session = compiler_session_create(filename, &options);
+        parallel_session->lexer = lexer_create(filename);
+        lexer_lexall(parallel_session->lexer, false);
+        lexer_set_cursor(parallel_session->lexer, 0);
+        parallel_session->ast = ast_create();
+        start = bench_now();
+        parallel_session->ast->root = ast_parse_program_parallel(parallel_session->lexer, threads);
+        bench_record(&parallel, i, bench_now() - start);
+        compiler_session_destroy(parallel_session);
+    }
+
+    printf("%s: %zu bytes, %zu tokens, %zu nodes, %zu iterations, %s scanner\n", filename, size, token_count, node_count,
+           iterations, scan.name);
+    printf("  lex      best %9.3f ms, mean %9.3f ms, %8.1f MB/s, %7.2f Mtokens/s\n", lex.best * 1e3,
+           lex.total / iterations * 1e3, size / lex.best / 1e6, token_count / lex.best / 1e6);
+    printf("  parse    best %9.3f ms, mean %9.3f ms, %8.2f Mtokens/s, %7.2f Mnodes/s\n", parse.best * 1e3,
+           parse.total / iterations * 1e3, token_count / parse.best / 1e6, node_count / parse.best / 1e6);
+    printf("  parse/%-2zu best %9.3f ms, mean %9.3f ms, %8.2f Mtokens/s, %7.2f Mnodes/s\n", threads, parallel.best * 1e3,
+           parallel.total / iterations * 1e3, token_count / parallel.best / 1e6, node_count / parallel.best / 1e6);
+    printf("  codegen  best %9.3f ms, mean %9.3f ms, %8.2f Mnodes/s\n", codegen.best * 1e3, codegen.total / iterations * 1e3,
+           node_count / codegen.best / 1e6);
+    printf("  write    best %9.3f ms, mean %9.3f ms\n", write.best * 1e3, write.total / iterations * 1e3);
+    printf("  peak RSS %zu KB\n", bench_peak_rss_kb());
+}
+
+void bench_suite(size_t iterations) {
+    for (size_t i = 0; i < sizeof(corpora) / sizeof(corpora[0]); i++) {
+        char filename[64];
+        snprintf(filename, sizeof(filename), "bench_%s.syn", corpora[i].name);
+        if (!bench_generate(corpora[i].name, corpora[i].default_count, filename)) {
+            return;
+        }
+        bench_file(filename, iterations);
+        remove(filename);
+    }
+}
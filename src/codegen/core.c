@@ -1,76 +1,114 @@
+#include <assert.h>
 #include <llvm-c/Analysis.h>
-#include <llvm-c/ExecutionEngine.h>
+#include <llvm-c/TargetMachine.h>
 #include <string.h>
 
 #include "codegen.h"
 #include "node.h"
 #include "utils/codegen_data.h"
+#include "utils/interner.h"
+#include "utils/recovery.h"
+#include "utils/type_registry.h"
 
-extern const char* types[];
-extern const size_t BUILTIN_TYPE_COUNT;
-size_t user_type_count = 0;
+extern _Thread_local ASTData* ast_data;
 
-CodegenData* codegen_data;
-LLVMTypeRef* llvm_types;
+// Live for the duration of one ast_to_llvm call on the calling thread
+_Thread_local CodegenData* codegen_data = NULL;
+_Thread_local LLVMTypeRef* llvm_types = NULL;
 
 void convert_all_types(LLVMContextRef ctx) {
-    llvm_types = calloc(BUILTIN_TYPE_COUNT - 1, sizeof(LLVMTypeRef));
+    // Indexed by DataType id, struct declarations fill in their own entries
+    llvm_types = calloc(type_registry->count, sizeof(LLVMTypeRef));
     llvm_types[DATA_TYPE_I8] = LLVMInt8TypeInContext(ctx);
     llvm_types[DATA_TYPE_I16] = LLVMInt16TypeInContext(ctx);
     llvm_types[DATA_TYPE_I32] = LLVMInt32TypeInContext(ctx);
     llvm_types[DATA_TYPE_I64] = LLVMInt64TypeInContext(ctx);
     llvm_types[DATA_TYPE_F32] = LLVMFloatTypeInContext(ctx);
     llvm_types[DATA_TYPE_F64] = LLVMDoubleTypeInContext(ctx);
-    llvm_types[DATA_TYPE_STR] = LLVMPointerType(LLVMInt8Type(), 0);
+    llvm_types[DATA_TYPE_STR] = LLVMPointerType(LLVMInt8TypeInContext(ctx), 0);
     llvm_types[DATA_TYPE_CHR] = LLVMInt8TypeInContext(ctx);
     llvm_types[DATA_TYPE_BLN] = LLVMInt1TypeInContext(ctx);
     llvm_types[DATA_TYPE_VOID] = LLVMVoidTypeInContext(ctx);
-    llvm_types[DATA_TYPE_PTR] = LLVMPointerType(LLVMInt8Type(), 0);
+    llvm_types[DATA_TYPE_PTR] = LLVMPointerType(LLVMInt8TypeInContext(ctx), 0);
 }
 
-void ast_to_llvm(AST* ast, const char* filename, const char* output, bool dump) {
+static LLVMModuleRef ast_to_module_part(AST* ast, const char* filename, bool dump, size_t partition, size_t partition_count) {
+    assert(interner != NULL && type_registry != NULL && ast_data == ast->data &&
+           "AST of a compiler session not bound to this thread");
     LLVMContextRef ctx = LLVMContextCreate();
     LLVMModuleRef module = LLVMModuleCreateWithNameInContext(filename, ctx);
     LLVMBuilderRef builder = LLVMCreateBuilderInContext(ctx);
 
     codegen_data = codegen_data_create(module, ctx);
+    codegen_data->partition = partition;
+    codegen_data->partition_count = partition_count;
 
     convert_all_types(ctx);
 
+    // Frees the module and the thread's code generator state before the error
+    // reaches the session
+    jmp_buf recovery;
+    jmp_buf* outer = recovery_point;
+    if (setjmp(recovery) != 0) {
+        recovery_point = outer;
+        LLVMDisposeBuilder(builder);
+        codegen_destroy_module(module);
+        recovery_fail();
+    }
+    recovery_point = &recovery;
+
     visit_node(ast->root, builder);
 
-    char* error = NULL;
     if (dump) LLVMDumpModule(module);
-    LLVMVerifyModule(module, LLVMAbortProcessAction, &error);
-    LLVMDisposeMessage(error);
+    if (LLVMVerifyModule(module, LLVMPrintMessageAction, NULL)) {
+        fprintf(stderr, "Error: Generated invalid code for %s\n", filename);
+        recovery_fail();
+    }
+    recovery_point = outer;
     // set target triple for module
     char* target = LLVMGetDefaultTargetTriple();
     LLVMSetTarget(module, target);
     LLVMDisposeMessage(target);
 
-    // Assuming you have an LLVM module `module` and a function named "add" in it
-    LLVMExecutionEngineRef engine;
-    error = NULL;
-    LLVMCreateExecutionEngineForModule(&engine, module, &error);
+    LLVMDisposeBuilder(builder);
+    return module;
+}
 
-    LLVMPrintModuleToFile(module, output, &error);
-    if (error) {
-        printf("Error: %s\n", error);
-        LLVMDisposeMessage(error);
-    }
+LLVMModuleRef ast_to_module(AST* ast, const char* filename, bool dump) {
+    return ast_to_module_part(ast, filename, dump, 0, 1);
+}
+
+LLVMModuleRef ast_to_module_partition(AST* ast, const char* filename, size_t partition, size_t partition_count) {
+    return ast_to_module_part(ast, filename, false, partition, partition_count);
+}
 
-    LLVMRemoveModule(engine, module, &module, &error);
-    if (error) {
-        printf("Error: %s\n", error);
+bool codegen_write_ir(LLVMModuleRef module, const char* output) {
+    char* error = NULL;
+    if (LLVMPrintModuleToFile(module, output, &error)) {
+        fprintf(stderr, "Error: Could not write %s: %s\n", output, error);
         LLVMDisposeMessage(error);
+        return false;
     }
+    return true;
+}
 
-    LLVMDisposeExecutionEngine(engine);
-    LLVMDisposeBuilder(builder);
+void codegen_destroy_module(LLVMModuleRef module) {
+    LLVMContextRef ctx = LLVMGetModuleContext(module);
     LLVMDisposeModule(module);
+    codegen_data_destroy(codegen_data);
+    codegen_data = NULL;
+    free(llvm_types);
+    llvm_types = NULL;
     LLVMContextDispose(ctx);
 }
 
+bool ast_to_llvm(AST* ast, const char* filename, const char* output, bool dump) {
+    LLVMModuleRef module = ast_to_module(ast, filename, dump);
+    bool written = codegen_write_ir(module, output);
+    codegen_destroy_module(module);
+    return written;
+}
+
 LLVMValueRef visit_node(Node* node, LLVMBuilderRef builder) {
     switch (node->type) {
         case NODE_PROGRAM:
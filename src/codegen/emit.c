@@ -0,0 +1,173 @@
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/PassBuilder.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "codegen.h"
+#include "utils/process.h"
+
+#ifdef _WIN32
+#define CODEGEN_DEFAULT_LINKER "clang"
+#define CODEGEN_OBJECT_EXTENSION ".obj"
+#else
+#define CODEGEN_DEFAULT_LINKER "cc"
+#define CODEGEN_OBJECT_EXTENSION ".o"
+#endif
+
+void codegen_init_native_target() {
+    LLVMInitializeNativeTarget();
+    LLVMInitializeNativeAsmPrinter();
+}
+
+LLVMTargetMachineRef codegen_create_target_machine(LLVMModuleRef module) {
+    const char* triple = LLVMGetTarget(module);
+    LLVMTargetRef target = NULL;
+    char* error = NULL;
+    if (LLVMGetTargetFromTriple(triple, &target, &error)) {
+        fprintf(stderr, "Error: No target for %s: %s\n", triple, error);
+        LLVMDisposeMessage(error);
+        return NULL;
+    }
+    char* cpu = LLVMGetHostCPUName();
+    char* features = LLVMGetHostCPUFeatures();
+    LLVMTargetMachineRef machine = LLVMCreateTargetMachine(target, triple, cpu, features, LLVMCodeGenLevelDefault, LLVMRelocPIC,
+                                                           LLVMCodeModelDefault);
+    LLVMDisposeMessage(cpu);
+    LLVMDisposeMessage(features);
+
+    LLVMTargetDataRef layout = LLVMCreateTargetDataLayout(machine);
+    LLVMSetModuleDataLayout(module, layout);
+    LLVMDisposeTargetData(layout);
+    return machine;
+}
+
+char* codegen_target_description() {
+    char* triple = LLVMGetDefaultTargetTriple();
+    char* cpu = LLVMGetHostCPUName();
+    char* features = LLVMGetHostCPUFeatures();
+    size_t length = strlen(triple) + strlen(cpu) + strlen(features) + 3;
+    char* description = malloc(length);
+    snprintf(description, length, "%s %s %s", triple, cpu, features);
+    LLVMDisposeMessage(triple);
+    LLVMDisposeMessage(cpu);
+    LLVMDisposeMessage(features);
+    return description;
+}
+
+bool codegen_optimize(LLVMModuleRef module, const char* passes) {
+    LLVMTargetMachineRef machine = codegen_create_target_machine(module);
+    if (machine == NULL) {
+        return false;
+    }
+    LLVMPassBuilderOptionsRef options = LLVMCreatePassBuilderOptions();
+    LLVMErrorRef error = LLVMRunPasses(module, passes, machine, options);
+    LLVMDisposePassBuilderOptions(options);
+    LLVMDisposeTargetMachine(machine);
+    if (error != NULL) {
+        char* message = LLVMGetErrorMessage(error);
+        fprintf(stderr, "Error: Could not run passes %s: %s\n", passes, message);
+        LLVMDisposeErrorMessage(message);
+        return false;
+    }
+    return true;
+}
+
+static bool codegen_emit_machine_code(LLVMModuleRef module, LLVMCodeGenFileType type, const char* output) {
+    LLVMTargetMachineRef machine = codegen_create_target_machine(module);
+    if (machine == NULL) {
+        return false;
+    }
+    char* error = NULL;
+    bool emitted = !LLVMTargetMachineEmitToFile(machine, module, (char*)output, type, &error);
+    if (!emitted) {
+        fprintf(stderr, "Error: Could not write %s: %s\n", output, error);
+        LLVMDisposeMessage(error);
+    }
+    LLVMDisposeTargetMachine(machine);
+    return emitted;
+}
+
+// The C compiler driver knows where the C runtime and its start files live
+bool codegen_link(char** objects, size_t object_count, const char* output, char** link_inputs, size_t link_input_count,
+                  bool relocatable) {
+    const char* linker = getenv("CC");
+    if (linker == NULL || linker[0] == '\0') {
+        linker = CODEGEN_DEFAULT_LINKER;
+    }
+    char** argv = malloc(sizeof(char*) * (object_count + link_input_count + 6));
+    size_t argc = 0;
+    argv[argc++] = (char*)linker;
+    if (relocatable) {
+        argv[argc++] = "-r";
+    }
+    for (size_t i = 0; i < object_count; i++) {
+        argv[argc++] = objects[i];
+    }
+    for (size_t i = 0; i < link_input_count; i++) {
+        argv[argc++] = link_inputs[i];
+    }
+    argv[argc++] = "-o";
+    argv[argc++] = (char*)output;
+    argv[argc] = NULL;
+    int status = process_run(argv);
+    free(argv);
+    if (status != 0) {
+        fprintf(stderr, "Error: Linking %s with %s failed\n", output, linker);
+        return false;
+    }
+    return true;
+}
+
+bool codegen_emit(LLVMModuleRef module, CodegenOutput kind, const char* output, char** link_inputs, size_t link_input_count) {
+    switch (kind) {
+        case CODEGEN_OUTPUT_IR:
+            return codegen_write_ir(module, output);
+        case CODEGEN_OUTPUT_BITCODE:
+            if (LLVMWriteBitcodeToFile(module, output) != 0) {
+                fprintf(stderr, "Error: Could not write %s\n", output);
+                return false;
+            }
+            return true;
+        case CODEGEN_OUTPUT_ASSEMBLY:
+            return codegen_emit_machine_code(module, LLVMAssemblyFile, output);
+        case CODEGEN_OUTPUT_OBJECT:
+            return codegen_emit_machine_code(module, LLVMObjectFile, output);
+        case CODEGEN_OUTPUT_EXECUTABLE: {
+            char* object = malloc(strlen(output) + sizeof(CODEGEN_OBJECT_EXTENSION));
+            strcpy(object, output);
+            strcat(object, CODEGEN_OBJECT_EXTENSION);
+            bool linked = codegen_emit_machine_code(module, LLVMObjectFile, object) &&
+                          codegen_link(&object, 1, output, link_inputs, link_input_count, false);
+            remove(object);
+            free(object);
+            return linked;
+        }
+    }
+    return false;
+}
+
+bool codegen_parse_output(const char* name, CodegenOutput* kind) {
+    static const char* names[] = {"ll", "bc", "asm", "obj", "exe"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *kind = (CodegenOutput)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* codegen_output_extension(CodegenOutput kind) {
+    static const char* extensions[] = {
+        ".ll", ".bc", ".s", CODEGEN_OBJECT_EXTENSION,
+#ifdef _WIN32
+        ".exe",
+#else
+        "",
+#endif
+    };
+    return extensions[kind];
+}
@@ -1,15 +1,88 @@
 #include <llvm-c/Core.h>
+#include <math.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "codegen.h"
 #include "node.h"
 #include "utils/codegen_data.h"
+#include "utils/recovery.h"
 
 extern const char* types[];
 extern const size_t TYPE_COUNT;
 
-extern CodegenData* codegen_data;
-extern LLVMTypeRef* llvm_types;
+extern _Thread_local CodegenData* codegen_data;
+extern _Thread_local LLVMTypeRef* llvm_types;
+
+static bool is_float_type(LLVMTypeRef type) {
+    LLVMTypeKind kind = LLVMGetTypeKind(type);
+    return kind == LLVMFloatTypeKind || kind == LLVMDoubleTypeKind;
+}
+
+// Orders numeric types so that mixing two literals keeps the wider one
+static unsigned numeric_rank(LLVMTypeRef type) {
+    switch (LLVMGetTypeKind(type)) {
+        case LLVMIntegerTypeKind:
+            return LLVMGetIntTypeWidth(type);
+        case LLVMFloatTypeKind:
+            return 128 + 32;
+        case LLVMDoubleTypeKind:
+            return 128 + 64;
+        default:
+            return 0;
+    }
+}
+
+// Whether integer keeps its value in an integer type of width bits. i1 holds
+// 0 and 1 rather than 0 and -1.
+static bool integer_fits(long long integer, unsigned width) {
+    if (width >= 64) {
+        return true;
+    } else if (width == 1) {
+        return integer == 0 || integer == 1;
+    }
+    long long limit = 1LL << (width - 1);
+    return integer >= -limit && integer < limit;
+}
+
+LLVMValueRef codegen_fit_constant(LLVMValueRef value, LLVMTypeRef type) {
+    if (value == NULL || type == NULL || LLVMTypeOf(value) == type) {
+        return value;
+    }
+    bool to_integer = LLVMGetTypeKind(type) == LLVMIntegerTypeKind;
+    bool to_float = LLVMGetTypeKind(type) == LLVMFloatTypeKind;
+    if (LLVMIsAConstantInt(value) != NULL) {
+        unsigned width = LLVMGetIntTypeWidth(LLVMTypeOf(value));
+        long long integer = LLVMConstIntGetSExtValue(value);
+        if (to_integer) {
+            unsigned fit_width = LLVMGetIntTypeWidth(type);
+            if (fit_width < width && !integer_fits(integer, fit_width)) {
+                fprintf(stderr, "Error: Integer constant %lld does not fit in i%u\n", integer, fit_width);
+                recovery_fail();
+            }
+            return LLVMConstIntCast(value, type, true);
+        } else if (is_float_type(type)) {
+            // Compared as double, which holds every float exactly
+            double real = to_float ? (double)(float)integer : (double)integer;
+            if (width > 1 && (real < -0x1p63 || real >= 0x1p63 || (long long)real != integer)) {
+                fprintf(stderr, "Error: Integer constant %lld can not be represented exactly in f%d\n", integer,
+                        to_float ? 32 : 64);
+                recovery_fail();
+            }
+            return LLVMConstSIToFP(value, type);
+        }
+    } else if (LLVMIsAConstantFP(value) != NULL && is_float_type(type)) {
+        // Rounding to the nearest float is fine, overflowing to infinity is not
+        LLVMBool loses_info;
+        double real = LLVMConstRealGetDouble(value, &loses_info);
+        if (to_float && !isinf(real) && isinf((float)real)) {
+            fprintf(stderr, "Error: Float constant %g does not fit in f32\n", real);
+            recovery_fail();
+        }
+        return LLVMConstFPCast(value, type);
+    }
+    return value;
+}
 
 LLVMValueRef visit_node_unary_operator(Node* node, LLVMBuilderRef builder, LLVMValueRef value1) {
     const char* op = node->data;
@@ -21,27 +94,29 @@ LLVMValueRef visit_node_unary_operator(Node* node, LLVMBuilderRef builder, LLVMV
 
     LLVMTypeRef value1_type = LLVMTypeOf(value1);
 
-    if (strcmp(op, "&") == 0) {
+    if (node->op == OPERATOR_BIT_AND) {
         return value1;
-    } else if (strcmp(op, "*") == 0) {
+    } else if (node->op == OPERATOR_MUL) {
         // Dereference
         LLVMValueRef deref1 = LLVMBuildLoad2(builder, value1_type, value1, "deref");
         return deref1;
     }
 
     if (LLVMGetTypeKind(value1_type) == LLVMIntegerTypeKind) {
-        if (strcmp(op, "-") == 0) {
-            return LLVMBuildNeg(builder, value1, "negtmp");
-        } else if (strcmp(op, "!") == 0) {
-            return LLVMBuildNot(builder, value1, "nottmp");
-        } else {
-            printf("Error: Unsupported operator '%s'\n", op);
+        switch (node->op) {
+            case OPERATOR_SUB:
+                return LLVMBuildNeg(builder, value1, "negtmp");
+            case OPERATOR_NOT:
+                return LLVMBuildNot(builder, value1, "nottmp");
+            default:
+                printf("Error: Unsupported operator '%s'\n", op);
         }
-    } else if (LLVMGetTypeKind(value1_type) == LLVMFloatTypeKind) {
-        if (strcmp(op, "-") == 0) {
-            return LLVMBuildFNeg(builder, value1, "negtmp");
-        } else {
-            printf("Error: Unsupported operator '%s'\n", op);
+    } else if (is_float_type(value1_type)) {
+        switch (node->op) {
+            case OPERATOR_SUB:
+                return LLVMBuildFNeg(builder, value1, "negtmp");
+            default:
+                printf("Error: Unsupported operator '%s'\n", op);
         }
     } else {
         printf("Error: Unsupported type %s\n", LLVMPrintTypeToString(value1_type));
@@ -57,6 +132,14 @@ LLVMValueRef visit_node_binary_operator(Node* node, LLVMBuilderRef builder, LLVM
         printf("Error: Operator '%s' could not be applied\n", op);
         return NULL;
     }
+    // A literal takes the type of the other operand
+    bool constant1 = LLVMIsConstant(value1);
+    bool constant2 = LLVMIsConstant(value2);
+    if (constant1 && (!constant2 || numeric_rank(LLVMTypeOf(value1)) < numeric_rank(LLVMTypeOf(value2)))) {
+        value1 = codegen_fit_constant(value1, LLVMTypeOf(value2));
+    } else if (constant2) {
+        value2 = codegen_fit_constant(value2, LLVMTypeOf(value1));
+    }
 
     LLVMTypeRef value1_type = LLVMTypeOf(value1);
     LLVMTypeRef value2_type = LLVMTypeOf(value2);
@@ -67,44 +150,46 @@ LLVMValueRef visit_node_binary_operator(Node* node, LLVMBuilderRef builder, LLVM
     }
 
     if (LLVMGetTypeKind(value1_type) == LLVMIntegerTypeKind) {
-        if (strcmp(op, "+") == 0) {
-            return LLVMBuildAdd(builder, value1, value2, "addtmp");
-        } else if (strcmp(op, "-") == 0) {
-            return LLVMBuildSub(builder, value1, value2, "subtmp");
-        } else if (strcmp(op, "*") == 0) {
-            return LLVMBuildMul(builder, value1, value2, "multmp");
-        } else if (strcmp(op, "/") == 0) {
-            return LLVMBuildSDiv(builder, value1, value2, "divtmp");
-        } else if (strcmp(op, "%") == 0) {
-            return LLVMBuildSRem(builder, value1, value2, "modtmp");
-        } else if (strcmp(op, "==") == 0) {
-            return LLVMBuildICmp(builder, LLVMIntEQ, value1, value2, "eqtmp");
-        } else if (strcmp(op, "!=") == 0) {
-            return LLVMBuildICmp(builder, LLVMIntNE, value1, value2, "neqtmp");
-        } else if (strcmp(op, "<") == 0) {
-            return LLVMBuildICmp(builder, LLVMIntSLT, value1, value2, "lttmp");
-        } else if (strcmp(op, ">") == 0) {
-            return LLVMBuildICmp(builder, LLVMIntSGT, value1, value2, "gttmp");
-        } else if (strcmp(op, "<=") == 0) {
-            return LLVMBuildICmp(builder, LLVMIntSLE, value1, value2, "letmp");
-        } else if (strcmp(op, ">=") == 0) {
-            return LLVMBuildICmp(builder, LLVMIntSGE, value1, value2, "getmp");
-        } else if (strcmp(op, "&&") == 0) {
-            return LLVMBuildAnd(builder, value1, value2, "andtmp");
-        } else if (strcmp(op, "||") == 0) {
-            return LLVMBuildOr(builder, value1, value2, "ortmp");
-        } else {
-            printf("Error: Unsupported operator '%s'\n", op);
+        switch (node->op) {
+            case OPERATOR_ADD:
+                return LLVMBuildAdd(builder, value1, value2, "addtmp");
+            case OPERATOR_SUB:
+                return LLVMBuildSub(builder, value1, value2, "subtmp");
+            case OPERATOR_MUL:
+                return LLVMBuildMul(builder, value1, value2, "multmp");
+            case OPERATOR_DIV:
+                return LLVMBuildSDiv(builder, value1, value2, "divtmp");
+            case OPERATOR_MOD:
+                return LLVMBuildSRem(builder, value1, value2, "modtmp");
+            case OPERATOR_EQ:
+                return LLVMBuildICmp(builder, LLVMIntEQ, value1, value2, "eqtmp");
+            case OPERATOR_NE:
+                return LLVMBuildICmp(builder, LLVMIntNE, value1, value2, "neqtmp");
+            case OPERATOR_LT:
+                return LLVMBuildICmp(builder, LLVMIntSLT, value1, value2, "lttmp");
+            case OPERATOR_GT:
+                return LLVMBuildICmp(builder, LLVMIntSGT, value1, value2, "gttmp");
+            case OPERATOR_LE:
+                return LLVMBuildICmp(builder, LLVMIntSLE, value1, value2, "letmp");
+            case OPERATOR_GE:
+                return LLVMBuildICmp(builder, LLVMIntSGE, value1, value2, "getmp");
+            case OPERATOR_AND:
+                return LLVMBuildAnd(builder, value1, value2, "andtmp");
+            case OPERATOR_OR:
+                return LLVMBuildOr(builder, value1, value2, "ortmp");
+            default:
+                printf("Error: Unsupported operator '%s'\n", op);
         }
-    } else if (LLVMGetTypeKind(value1_type) == LLVMFloatTypeKind) {
-        if (strcmp(op, "+") == 0) {
-            return LLVMBuildFAdd(builder, value1, value2, "addtmp");
-        } else if (strcmp(op, "-") == 0) {
-            return LLVMBuildFSub(builder, value1, value2, "subtmp");
-        } else if (strcmp(op, "*") == 0) {
-            return LLVMBuildFMul(builder, value1, value2, "multmp");
-        } else {
-            printf("Error: Unsupported operator '%s'\n", op);
+    } else if (is_float_type(value1_type)) {
+        switch (node->op) {
+            case OPERATOR_ADD:
+                return LLVMBuildFAdd(builder, value1, value2, "addtmp");
+            case OPERATOR_SUB:
+                return LLVMBuildFSub(builder, value1, value2, "subtmp");
+            case OPERATOR_MUL:
+                return LLVMBuildFMul(builder, value1, value2, "multmp");
+            default:
+                printf("Error: Unsupported operator '%s'\n", op);
         }
     } else {
         printf("Error: Unsupported type %s\n", LLVMPrintTypeToString(value1_type));
@@ -133,21 +218,21 @@ LLVMValueRef visit_node_expression(Node* node, LLVMBuilderRef builder) {
             case NODE_OPERATOR: {
                 if (node->num_children < 2) {
                     fprintf(stderr, "Error: Operator '%s' could not be applied\n", (char*)node->data);
-                    exit(1);
+                    recovery_fail();
                     return NULL;
                 } else if (node->num_children == 2) {
                     Node* rhs;
                     rhs = node->children[i + 1];
                     LLVMValueRef operand = visit_node(rhs, builder);
                     // Weird hack to get the type of the operand
-                    if (strcmp((char*)child->data, "&") == 0 || strcmp((char*)child->data, "*") == 0) {
+                    if (child->op == OPERATOR_BIT_AND || child->op == OPERATOR_MUL) {
                         if (rhs->type != NODE_IDENTIFIER) {
                             fprintf(stderr, "Error: Only identifiers can be derefenced. Recieved %s\n", (char*)node->data);
-                            exit(1);
+                            recovery_fail();
                             return NULL;
                         }
                     }
-                    if (strcmp((char*)child->data, "&") == 0) {
+                    if (child->op == OPERATOR_BIT_AND) {
                         operand = visit_node_identifier(rhs, builder, false);
                     }
                     lhs = visit_node_unary_operator(child, builder, operand);
@@ -160,8 +245,8 @@ LLVMValueRef visit_node_expression(Node* node, LLVMBuilderRef builder) {
                     i++;
                 } else {
                     fprintf(stderr, "Error: Operator '%s' could not be applied\n", (char*)node->data);
-                    fprintf(stderr, "Error: Node with %lu children\n", node->num_children);
-                    exit(1);
+                    fprintf(stderr, "Error: Node with %u children\n", node->num_children);
+                    recovery_fail();
                     return NULL;
                 }
                 continue;
@@ -242,35 +327,41 @@ LLVMValueRef visit_node_string_literal(Node* node, LLVMBuilderRef builder) {
     return string;
 }
 
+// Unsuffixed integer literals are i32 unless they need more bits and
+// unsuffixed float literals keep full double precision. Whoever consumes
+// them narrows or widens the constant with codegen_fit_constant.
 LLVMValueRef visit_node_numeric_literal(Node* node, LLVMBuilderRef builder) {
     (void)builder;
-    LLVMContextRef ctx = codegen_data->context;
-    const char* value_str = node->data;
-    float value = strtof(value_str, NULL);
-    return LLVMConstInt(LLVMInt32TypeInContext(ctx), value, 0);
+    if (node->literal_type != DATA_TYPE_TOTAL) {
+        return codegen_fit_constant(LLVMConstInt(llvm_types[DATA_TYPE_I64], node->integer, 0), llvm_types[node->literal_type]);
+    } else if (node->integer > INT32_MAX) {
+        return LLVMConstInt(llvm_types[DATA_TYPE_I64], node->integer, 0);
+    }
+    return LLVMConstInt(llvm_types[DATA_TYPE_I32], node->integer, 0);
 }
 
 LLVMValueRef visit_node_float_literal(Node* node, LLVMBuilderRef builder) {
     (void)builder;
-    const char* value_str = node->data;
-    float value = strtof(value_str, NULL);
-    return LLVMConstReal(LLVMFloatType(), value);
+    if (node->literal_type != DATA_TYPE_TOTAL) {
+        return codegen_fit_constant(LLVMConstReal(llvm_types[DATA_TYPE_F64], node->real), llvm_types[node->literal_type]);
+    }
+    return LLVMConstReal(llvm_types[DATA_TYPE_F64], node->real);
 }
 
 LLVMValueRef visit_node_true_literal(Node* node, LLVMBuilderRef builder) {
     (void)node;
     (void)builder;
-    return LLVMConstInt(LLVMInt1Type(), 1, 0);
+    return LLVMConstInt(llvm_types[DATA_TYPE_BLN], 1, 0);
 }
 
 LLVMValueRef visit_node_false_literal(Node* node, LLVMBuilderRef builder) {
     (void)node;
     (void)builder;
-    return LLVMConstInt(LLVMInt1Type(), 0, 0);
+    return LLVMConstInt(llvm_types[DATA_TYPE_BLN], 0, 0);
 }
 
 LLVMValueRef visit_node_null_literal(Node* node, LLVMBuilderRef builder) {
     (void)node;
     (void)builder;
-    return LLVMConstPointerNull(LLVMPointerType(LLVMInt8Type(), 0));
+    return LLVMConstPointerNull(llvm_types[DATA_TYPE_PTR]);
 }
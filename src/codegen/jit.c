@@ -0,0 +1,79 @@
+#include <llvm-c/Error.h>
+#include <llvm-c/LLJIT.h>
+#include <llvm-c/Orc.h>
+#include <stdio.h>
+
+#include "codegen.h"
+
+typedef int (*CodegenEntryPoint)();
+
+static bool codegen_jit_check(LLVMErrorRef error, const char* what) {
+    if (error == NULL) {
+        return true;
+    }
+    char* message = LLVMGetErrorMessage(error);
+    fprintf(stderr, "Error: %s: %s\n", what, message);
+    LLVMDisposeErrorMessage(message);
+    return false;
+}
+
+// Compiled here rather than handed over as IR, as the JIT wants IR modules in
+// a context of its own
+static LLVMMemoryBufferRef codegen_jit_object(LLVMModuleRef module) {
+    LLVMTargetMachineRef machine = codegen_create_target_machine(module);
+    if (machine == NULL) {
+        return NULL;
+    }
+    LLVMMemoryBufferRef object = NULL;
+    char* error = NULL;
+    if (LLVMTargetMachineEmitToMemoryBuffer(machine, module, LLVMObjectFile, &error, &object)) {
+        fprintf(stderr, "Error: Could not compile for the JIT: %s\n", error);
+        LLVMDisposeMessage(error);
+        object = NULL;
+    }
+    LLVMDisposeTargetMachine(machine);
+    return object;
+}
+
+bool codegen_run(LLVMModuleRef module, char** libraries, size_t library_count, int* exit_code) {
+    LLVMOrcLLJITRef jit = NULL;
+    if (!codegen_jit_check(LLVMOrcCreateLLJIT(&jit, NULL), "Could not create the JIT")) {
+        return false;
+    }
+    LLVMOrcJITDylibRef dylib = LLVMOrcLLJITGetMainJITDylib(jit);
+    char prefix = LLVMOrcLLJITGetGlobalPrefix(jit);
+
+    // Externs resolve against the given libraries first, then the compiler
+    // process itself and the C library it links
+    bool ready = true;
+    for (size_t i = 0; i < library_count && ready; i++) {
+        LLVMOrcDefinitionGeneratorRef generator = NULL;
+        ready = codegen_jit_check(LLVMOrcCreateDynamicLibrarySearchGeneratorForPath(&generator, libraries[i], prefix, NULL, NULL),
+                                  libraries[i]);
+        if (ready) {
+            LLVMOrcJITDylibAddGenerator(dylib, generator);
+        }
+    }
+    LLVMOrcDefinitionGeneratorRef process = NULL;
+    if (ready && codegen_jit_check(LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(&process, prefix, NULL, NULL),
+                                   "Could not search the host process")) {
+        LLVMOrcJITDylibAddGenerator(dylib, process);
+    } else {
+        ready = false;
+    }
+
+    LLVMMemoryBufferRef object = ready ? codegen_jit_object(module) : NULL;
+    if (object != NULL && !codegen_jit_check(LLVMOrcLLJITAddObjectFile(jit, dylib, object), "Could not load the module")) {
+        object = NULL;
+    }
+
+    LLVMOrcExecutorAddress main_address = 0;
+    bool ran = object != NULL && codegen_jit_check(LLVMOrcLLJITLookup(jit, &main_address, "main"), "Could not find main");
+    if (ran) {
+        CodegenEntryPoint entry_point = (CodegenEntryPoint)main_address;
+        *exit_code = entry_point();
+    }
+    fflush(stdout);
+    codegen_jit_check(LLVMOrcDisposeLLJIT(jit), "Could not tear down the JIT");
+    return ran;
+}
@@ -6,18 +6,50 @@
 #include "codegen.h"
 #include "utils/ast_data.h"
 #include "utils/codegen_data.h"
+#include "utils/interner.h"
+#include "utils/recovery.h"
 
 extern const char* types[];
-extern const size_t BUILTIN_TYPE_COUNT;
-extern size_t user_type_count;
 
-extern ASTData* ast_data;
-extern CodegenData* codegen_data;
-extern LLVMTypeRef* llvm_types;
+extern _Thread_local ASTData* ast_data;
+extern _Thread_local CodegenData* codegen_data;
+extern _Thread_local LLVMTypeRef* llvm_types;
+
+// Stores value, first fitting a literal to the type pointer points at
+static void build_store(LLVMBuilderRef builder, LLVMValueRef value, LLVMValueRef pointer) {
+    LLVMBuildStore(builder, codegen_fit_constant(value, LLVMGetElementType(LLVMTypeOf(pointer))), pointer);
+}
+
+// Allocates a local in the entry block of the current function, after the
+// allocas already there, so that it is allocated once per call wherever it is
+// declared and mem2reg/SROA can promote it
+static LLVMValueRef build_entry_alloca(LLVMBuilderRef builder, LLVMTypeRef type, const char* name) {
+    LLVMValueRef function = LLVMGetBasicBlockParent(LLVMGetInsertBlock(builder));
+    LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(function);
+    LLVMValueRef position = LLVMGetFirstInstruction(entry);
+    while (position != NULL && LLVMIsAAllocaInst(position) != NULL) {
+        position = LLVMGetNextInstruction(position);
+    }
+
+    LLVMBuilderRef entry_builder = LLVMCreateBuilderInContext(codegen_data->context);
+    if (position != NULL) {
+        LLVMPositionBuilderBefore(entry_builder, position);
+    } else {
+        LLVMPositionBuilderAtEnd(entry_builder, entry);
+    }
+    LLVMValueRef alloca = LLVMBuildAlloca(entry_builder, type, name);
+    LLVMDisposeBuilder(entry_builder);
+    return alloca;
+}
 
 void visit_node_program(Node* node, LLVMBuilderRef builder) {
     for (size_t i = 0; i < node->num_children; i++) {
-        visit_node(node->children[i], builder);
+        Node* child = node->children[i];
+        if (child->type == NODE_FUNCTION_DECLARATION && child->children[child->num_children - 1]->type == NODE_BLOCK_STATEMENT) {
+            codegen_data->declare_only = codegen_data->body_count++ % codegen_data->partition_count != codegen_data->partition;
+        }
+        visit_node(child, builder);
+        codegen_data->declare_only = false;
     }
 }
 
@@ -32,7 +64,7 @@ void visit_node_variable_declaration(Node* node, LLVMBuilderRef builder) {
 
     if (var_name != NULL) {
         // Allocate variable
-        LLVMValueRef variable = LLVMBuildAlloca(builder, type, var_name);
+        LLVMValueRef variable = build_entry_alloca(builder, type, var_name);
         //  Add variable to current scope
         CodegenData_Variable* var = codegen_data_create_variable(var_name, variable, type_name, type);
         codegen_data_add_variable(codegen_data, var);
@@ -70,7 +102,7 @@ void visit_node_function_declaration(Node* node, LLVMBuilderRef builder) {
 
                 LLVMTypeRef type = NULL;
                 size_t data_type = get_data_type(type_node->data, ast_data)->id;
-                if (data_type == ast_data->data_type_count) {
+                if (data_type == ast_data->types->count) {
                     fprintf(stderr, "Error: Pointer '%s' could not be declared due to empty base data type\n", func_name);
                     return;
                 }
@@ -85,7 +117,7 @@ void visit_node_function_declaration(Node* node, LLVMBuilderRef builder) {
             }
             break;
         } else if (child->type == NODE_FUNCTION_ARGUMENT) {
-            if (strcmp(child->data, "...") == 0) {
+            if (child->op == OPERATOR_ELLIPSIS) {
                 is_vararg = true;
                 continue;
             }
@@ -100,11 +132,8 @@ void visit_node_function_declaration(Node* node, LLVMBuilderRef builder) {
         for (size_t i = 0; i < node->num_children; i++) {
             Node* child = node->children[i];
             if (child->type == NODE_FUNCTION_ARGUMENT) {
-                if (strcmp(child->data, "...") == 0) {
-                    is_vararg = true;
-                    arg_types[arg_index] = LLVMPointerType(LLVMVoidType(), 0);
-                    arg_names[arg_index] = child->data;
-                    arg_index++;
+                // The ellipsis makes the function vararg, it is not a parameter
+                if (child->op == OPERATOR_ELLIPSIS) {
                     continue;
                 }
                 Node* type_node = child->children[0];
@@ -123,7 +152,7 @@ void visit_node_function_declaration(Node* node, LLVMBuilderRef builder) {
                     }
 
                     size_t data_type = get_data_type(type_node->data, ast_data)->id;
-                    if (data_type == ast_data->data_type_count) {
+                    if (data_type == ast_data->types->count) {
                         fprintf(stderr, "Error: Pointer '%s' could not be declared due to empty base data type\n", func_name);
                         return;
                     }
@@ -163,15 +192,21 @@ void visit_node_function_declaration(Node* node, LLVMBuilderRef builder) {
         CodegenData_Function* function = codegen_data_create_function(func_name, func, return_type, arg_types, args, arg_count, is_vararg);
         codegen_data_add_function(codegen_data, function);
 
-        codegen_data_reset_scope(codegen_data);
+        if (codegen_data->declare_only) {
+            free(arg_names);
+            return;
+        }
         codegen_data->current_function = function;
 
+        codegen_data_push_scope(codegen_data);
+        codegen_data_add_parameters(codegen_data, function);
         for (size_t i = 0; i < node->num_children; i++) {
             Node* child = node->children[i];
             if (child->type == NODE_BLOCK_STATEMENT) {
                 visit_node_block_statement(child, builder);
             }
         }
+        codegen_data_pop_scope(codegen_data);
         free(arg_names);
     }
 }
@@ -203,7 +238,7 @@ void visit_node_pointer_declaration(Node* node, LLVMBuilderRef builder) {
             }
             base_type_name = type_node->data;
             size_t data_type = get_data_type(type_node->data, ast_data)->id;
-            if (data_type == ast_data->data_type_count) {
+            if (data_type == ast_data->types->count) {
                 fprintf(stderr, "Error: Pointer '%s' could not be declared due to empty base data type\n", var_name);
                 return;
             }
@@ -225,7 +260,7 @@ void visit_node_pointer_declaration(Node* node, LLVMBuilderRef builder) {
 
     if (var_name != NULL) {
         // Allocate variable
-        LLVMValueRef pointer = LLVMBuildAlloca(builder, type, var_name);
+        LLVMValueRef pointer = build_entry_alloca(builder, type, var_name);
         //  Add pointer to current scope
         CodegenData_Pointer* pointer_data = codegen_data_create_pointer(var_name, base_type_name, pointer, type, base_type, pointer_degree);
         codegen_data_add_pointer(codegen_data, pointer_data);
@@ -241,15 +276,9 @@ void visit_node_pointer_deref(Node* node, LLVMBuilderRef builder) {
     bool found = false;
 
     // Check if the pointer is one of the function arguments
-    uint32_t arg_count = codegen_data->current_function->parameter_count;
-    for (size_t i = 0; i < arg_count; i++) {
-        LLVMValueRef arg = LLVMGetParam(codegen_data->current_function->function, i);
-        const char* arg_name = LLVMGetValueName(arg);
-        if (strcmp(pointer_name, arg_name) == 0) {
-            pointer = arg;
-            found = true;
-            break;
-        }
+    pointer = codegen_data_lookup(codegen_data, CODEGEN_SYMBOL_PARAMETER, node->id);
+    if (pointer != NULL) {
+        found = true;
     }
 
     CodegenData_Pointer* pointer_data = codegen_data_get_pointer(codegen_data, pointer_name);
@@ -266,7 +295,7 @@ void visit_node_pointer_deref(Node* node, LLVMBuilderRef builder) {
     }
     Node* expression = node->children[0];
     LLVMValueRef value = visit_node_expression(expression, builder);
-    LLVMBuildStore(builder, value, pointer);
+    build_store(builder, value, pointer);
     return;
 }
 
@@ -280,9 +309,10 @@ LLVMBasicBlockRef create_if_block(Node* node, LLVMBuilderRef builder, const char
     (void)builder;
     LLVMContextRef ctx = codegen_data->context;
     LLVMBasicBlockRef block = LLVMAppendBasicBlockInContext(ctx, codegen_data->current_function->function, name);
-    LLVMBuilderRef block_builder = LLVMCreateBuilder();
+    LLVMBuilderRef block_builder = LLVMCreateBuilderInContext(codegen_data->context);
     LLVMPositionBuilderAtEnd(block_builder, block);
 
+    codegen_data_push_scope(codegen_data);
     for (size_t i = 0; i < node->num_children; i++) {
         if (node->children[i]->type == NODE_RETURN_STATEMENT) {
             LLVMValueRef return_value = visit_node_return_statement(node->children[i], block_builder);
@@ -293,6 +323,7 @@ LLVMBasicBlockRef create_if_block(Node* node, LLVMBuilderRef builder, const char
             visit_node(node->children[i], block_builder);
         }
     }
+    codegen_data_pop_scope(codegen_data);
 
     if (LLVMGetBasicBlockTerminator(block) == NULL) {
         LLVMBuildBr(block_builder, merge_block);
@@ -417,9 +448,11 @@ void visit_node_while_statement(Node* node, LLVMBuilderRef builder) {
             LLVMBuildCondBr(builder, condition, while_block, merge_block);
             LLVMAppendExistingBasicBlock(codegen_data->current_function->function, while_block);
             LLVMPositionBuilderAtEnd(builder, while_block);
+            codegen_data_push_scope(codegen_data);
             for (size_t j = 0; j < node->children[i]->num_children; j++) {
                 visit_node(node->children[i]->children[j], builder);
             }
+            codegen_data_pop_scope(codegen_data);
             LLVMBuildBr(builder, while_cond_check_block);
         }
     }
@@ -447,7 +480,7 @@ void visit_node_assignment(Node* node, LLVMBuilderRef builder) {
     }
 
     if (variable != NULL && value != NULL) {
-        LLVMBuildStore(builder, value, variable);
+        build_store(builder, value, variable);
     } else {
         printf("Error: Variable '%s' could not be assigned\n", (char*)node->data);
     }
@@ -455,43 +488,28 @@ void visit_node_assignment(Node* node, LLVMBuilderRef builder) {
 
 LLVMValueRef visit_node_identifier(Node* node, LLVMBuilderRef builder, bool deref) {
     const char* identifier = node->data;
+    uint32_t identifier_id = node->id;
     // LLVMBasicBlockRef currentBlock = LLVMGetInsertBlock(builder);
-    LLVMValueRef currentFunction = codegen_data->current_function->function;
-    unsigned int paramCount = LLVMCountParams(currentFunction);
-
-    LLVMValueRef value = NULL;
-
-    for (unsigned int i = 0; i < paramCount; i++) {
-        LLVMValueRef param = LLVMGetParam(currentFunction, i);
-        const char* param_name = LLVMGetValueName(param);
-        if (strcmp(param_name, identifier) == 0) {
-            value = param;
-            break;
-        }
-    }
+    LLVMValueRef value = codegen_data_lookup(codegen_data, CODEGEN_SYMBOL_PARAMETER, identifier_id);
 
     // Check if variable is in the current scope
     if (value == NULL) {
-        for (size_t i = 0; i < codegen_data->variable_count; i++) {
-            if (strcmp(codegen_data->variables[i]->variable_name, identifier) == 0) {
-                value = codegen_data->variables[i]->variable;
-                if (deref) {
-                    value = LLVMBuildLoad2(builder, codegen_data->variables[i]->variable_type, value, identifier);
-                }
-                break;
+        CodegenData_Variable* variable = codegen_data_lookup(codegen_data, CODEGEN_SYMBOL_VARIABLE, identifier_id);
+        if (variable != NULL) {
+            value = variable->variable;
+            if (deref) {
+                value = LLVMBuildLoad2(builder, variable->variable_type, value, identifier);
             }
         }
     }
 
     // Check if pointer is in the current scope
     if (value == NULL) {
-        for (size_t i = 0; i < codegen_data->pointer_count; i++) {
-            if (strcmp(codegen_data->pointers[i]->pointer_name, identifier) == 0) {
-                value = codegen_data->pointers[i]->pointer;
-                if (deref) {
-                    value = LLVMBuildLoad2(builder, codegen_data->pointers[i]->pointer_type, value, identifier);
-                }
-                break;
+        CodegenData_Pointer* pointer = codegen_data_lookup(codegen_data, CODEGEN_SYMBOL_POINTER, identifier_id);
+        if (pointer != NULL) {
+            value = pointer->pointer;
+            if (deref) {
+                value = LLVMBuildLoad2(builder, pointer->pointer_type, value, identifier);
             }
         }
     }
@@ -514,7 +532,7 @@ void visit_node_block_statement(Node* node, LLVMBuilderRef builder) {
     (void)builder;
     LLVMContextRef ctx = codegen_data->context;
     LLVMBasicBlockRef block = LLVMAppendBasicBlockInContext(ctx, codegen_data->current_function->function, "entry");
-    LLVMBuilderRef block_builder = LLVMCreateBuilder();
+    LLVMBuilderRef block_builder = LLVMCreateBuilderInContext(codegen_data->context);
     LLVMPositionBuilderAtEnd(block_builder, block);
     LLVMValueRef return_value = NULL;
     for (size_t i = 0; i < node->num_children; i++) {
@@ -549,7 +567,7 @@ LLVMValueRef visit_node_return_statement(Node* node, LLVMBuilderRef builder) {
             value = visit_node_identifier(node->children[i], builder, true);
         }
     }
-    return value;
+    return codegen_fit_constant(value, codegen_data->current_function->return_type);
 }
 
 void visit_node_array_declaration(Node* node, LLVMBuilderRef builder) {
@@ -577,7 +595,7 @@ void visit_node_array_declaration(Node* node, LLVMBuilderRef builder) {
     for (size_t i = 0; i < type_node->num_children; i++) {
         Node* child = type_node->children[i];
         if (child->type == NODE_NUMERIC_LITERAL) {
-            num_elements[i] = atoi(child->data);
+            num_elements[i] = child->integer;
             num_dimensions++;
         }
     }
@@ -598,7 +616,7 @@ void visit_node_array_declaration(Node* node, LLVMBuilderRef builder) {
             }
         }
 
-        array = LLVMBuildAlloca(builder, array_type, array_name);
+        array = build_entry_alloca(builder, array_type, array_name);
 
         CodegenData_Array* array_data = codegen_data_create_array(array_name, array, array_type, array_element_type, num_dimensions);
         codegen_data_add_array(codegen_data, array_data);
@@ -651,7 +669,7 @@ void visit_node_array_assignment(Node* node, LLVMBuilderRef builder) {
         LLVMTypeRef array_type = array_data->array_type;
         // LLVMTypeRef array_element_type = array_data->array_element_type;
 
-        LLVMValueRef zero_index = LLVMConstInt(LLVMInt32Type(), 0, false);
+        LLVMValueRef zero_index = LLVMConstInt(llvm_types[DATA_TYPE_I32], 0, false);
 
         size_t ind = 0;
         LLVMValueRef indices[2 * num_dimensions];
@@ -666,7 +684,7 @@ void visit_node_array_assignment(Node* node, LLVMBuilderRef builder) {
         }
 
         LLVMValueRef gep = LLVMBuildInBoundsGEP2(builder, array_type, array, indices, 2 * num_dimensions, "geptmp");
-        LLVMBuildStore(builder, value, gep);
+        build_store(builder, value, gep);
     } else {
         LLVMTypeRef array_type = pointer_data->pointer_type;
         LLVMTypeRef array_element_type = pointer_data->pointer_base_type;
@@ -687,7 +705,7 @@ void visit_node_array_assignment(Node* node, LLVMBuilderRef builder) {
         // Offset the pointer
         LLVMValueRef array_pointer = LLVMBuildLoad2(builder, pointer_type, array, "arrptr");
         LLVMValueRef gep = LLVMBuildInBoundsGEP2(builder, array_element_type, array_pointer, indices, num_dimensions, "geptmp");
-        LLVMBuildStore(builder, value, gep);
+        build_store(builder, value, gep);
     }
 }
 
@@ -724,7 +742,7 @@ LLVMValueRef visit_node_array_element(Node* node, LLVMBuilderRef builder) {
         LLVMTypeRef array_type = array_data->array_type;
         LLVMTypeRef array_element_type = array_data->array_element_type;
 
-        LLVMValueRef zero_index = LLVMConstInt(LLVMInt32Type(), 0, false);
+        LLVMValueRef zero_index = LLVMConstInt(llvm_types[DATA_TYPE_I32], 0, false);
 
         size_t ind = 0;
         LLVMValueRef indices[2 * num_dimensions];
@@ -816,15 +834,18 @@ LLVMValueRef visit_node_call_expression(Node* node, LLVMBuilderRef builder) {
     for (size_t i = 0; i < node->num_children; i++) {
         if (node->children[i]->type == NODE_EXPRESSION) {
             args[arg_count] = visit_node_expression(node->children[i], builder);
+            if (arg_count < param_count) {
+                args[arg_count] = codegen_fit_constant(args[arg_count], param_types[arg_count]);
+            }
             // Promote integer types to 32-bit
             // Promote float types to double
             if (is_function_vararg) {
                 if (LLVMGetTypeKind(LLVMTypeOf(args[arg_count])) == LLVMIntegerTypeKind) {
                     if (LLVMGetIntTypeWidth(LLVMTypeOf(args[arg_count])) < 32) {
-                        args[arg_count] = LLVMBuildIntCast2(builder, args[arg_count], LLVMInt32Type(), true, "intcast");
+                        args[arg_count] = LLVMBuildIntCast2(builder, args[arg_count], llvm_types[DATA_TYPE_I32], true, "intcast");
                     }
                 } else if (LLVMGetTypeKind(LLVMTypeOf(args[arg_count])) == LLVMFloatTypeKind) {
-                    args[arg_count] = LLVMBuildFPCast(builder, args[arg_count], LLVMDoubleType(), "fpcast");
+                    args[arg_count] = LLVMBuildFPCast(builder, args[arg_count], llvm_types[DATA_TYPE_F64], "fpcast");
                 }
             }
             arg_count++;
@@ -884,9 +905,7 @@ void visit_node_struct_declaration(Node *node) {
     codegen_data_add_struct(codegen_data, struct_data);
 
     // Add to types
-    user_type_count++;
-    llvm_types = realloc(llvm_types, sizeof(LLVMTypeRef) * (BUILTIN_TYPE_COUNT + user_type_count));
-    llvm_types[BUILTIN_TYPE_COUNT + user_type_count - 1] = struct_type;
+    llvm_types[get_data_type(struct_name, ast_data)->id] = struct_type;
     return;
 }
 
@@ -1000,7 +1019,7 @@ void visit_node_struct_member_assignment(Node* node, LLVMBuilderRef builder) {
                 gep = LLVMBuildStructGEP2(builder, struct_type, gep, member_indices[i], "strctgeptmp");
             }
         }
-        LLVMBuildStore(builder, value, gep);
+        build_store(builder, value, gep);
     } else {
         LLVMValueRef deref = LLVMBuildLoad2(builder, pointer_data->pointer_type, strct, "deref");
         LLVMValueRef gep = NULL;
@@ -1021,7 +1040,7 @@ void visit_node_struct_member_assignment(Node* node, LLVMBuilderRef builder) {
                 gep = LLVMBuildStructGEP2(builder, struct_type, gep, member_indices[i], "strctgeptmp");
             }
         }
-        LLVMBuildStore(builder, value, gep);
+        build_store(builder, value, gep);
     }
 
     free(member_names);
@@ -1041,7 +1060,7 @@ LLVMValueRef visit_node_struct_access(Node* node, LLVMBuilderRef builder) {
         Node* member_child = node->children[0];
         if (member_child->type != NODE_STRUCT_MEMBER) {
             printf("Error: Struct member '%s' has no type\n", (char*)member_child->data);
-            exit(EXIT_FAILURE);
+            recovery_fail();
         }
         member_names = realloc(member_names, sizeof(const char*) * member_depth + 1);
         member_names[member_depth] = member_child->data;
@@ -8,9 +8,12 @@
 #include "token.h"
 #include "utils/ast_data.h"
 
+#define AST_ARENA_CHUNK_SIZE (1024 * 1024)
+
 typedef struct {
     Node* root;
     ASTData* data;
+    Arena* arena;  // Every Node and child array of the tree
 } AST;
 
 AST* ast_create();
@@ -18,11 +21,21 @@ void ast_destroy(AST* ast);
 
 void ast_print(AST* ast);
 void ast_print_declarations();
-void _ast_error(int src_line, char* src_file, Token* token, char* message, ...);
+_Noreturn void _ast_error(int src_line, char* src_file, Token* token, char* message, ...);
 #define ast_error(token, message, ...) _ast_error(__LINE__, __FILE__, token, message, ##__VA_ARGS__)
 
 void ast_build(AST* ast, Lexer* lexer);
+// Lexes the whole file up front and parses function bodies on threads
+void ast_build_parallel(AST* ast, Lexer* lexer, size_t threads);
+// Like ast_build_parallel for a lexer lexall has run on. Top-level function
+// bodies whose opening brace is at one of the sorted token indices in skipped
+// are left out of the tree, so those functions are only declared.
+void ast_build_lexed(AST* ast, Lexer* lexer, size_t threads, const size_t* skipped, size_t skipped_count);
 Node* ast_parse_program(Lexer* lexer);
+// Parses declarations in order, then top-level function bodies on up to
+// threads threads. Needs every token lexed already. Gives the same tree as
+// ast_parse_program.
+Node* ast_parse_program_parallel(Lexer* lexer, size_t threads);
 Node* ast_parse_statement(Lexer* lexer);
 Node* ast_parse_function(Lexer* lexer);
 Node* ast_parse_if_statement(Lexer* lexer, bool is_elif);
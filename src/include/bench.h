@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Writes a synthetic corpus of the given kind (functions, nesting,
+// expressions or structs) scaled by count
+bool bench_generate(const char *kind, size_t count, const char *output);
+// Times lexing, parsing, code generation and writing the IR of a file
+// separately
+void bench_file(char *filename, size_t iterations);
+// Generates every corpus at its default size and benchmarks each one
+void bench_suite(size_t iterations);
@@ -1,14 +1,64 @@
 #pragma once
 #include <llvm-c/Core.h>
+#include <llvm-c/TargetMachine.h>
 
 #include "ast.h"
 
+typedef enum CodegenOutput {
+    CODEGEN_OUTPUT_IR,  // Textual LLVM IR
+    CODEGEN_OUTPUT_BITCODE,
+    CODEGEN_OUTPUT_ASSEMBLY,
+    CODEGEN_OUTPUT_OBJECT,
+    CODEGEN_OUTPUT_EXECUTABLE,
+} CodegenOutput;
+
 // In core.c
-void ast_to_llvm(AST* ast, const char* filename, const char* output, bool dump);
+// Builds and verifies the module in a context of its own, which lives until
+// codegen_destroy_module
+LLVMModuleRef ast_to_module(AST* ast, const char* filename, bool dump);
+// Like ast_to_module, but only builds the top-level function bodies whose
+// position modulo partition_count is partition and declares the others. The
+// partitions of a file link together into the same program as ast_to_module.
+LLVMModuleRef ast_to_module_partition(AST* ast, const char* filename, size_t partition, size_t partition_count);
+// Writes the module as textual LLVM IR, returns false if output could not be
+// written
+bool codegen_write_ir(LLVMModuleRef module, const char* output);
+// Releases the module, its context and the code generator state kept for it
+void codegen_destroy_module(LLVMModuleRef module);
+bool ast_to_llvm(AST* ast, const char* filename, const char* output, bool dump);
 void convert_all_types(LLVMContextRef ctx);
 
 LLVMValueRef visit_node(Node* node, LLVMBuilderRef builder);
 
+// In emit.c
+// Registers the host target, once before any thread emits machine code
+void codegen_init_native_target();
+// Machine for the host, position independent so that the result links into
+// the default PIE executables of most toolchains. Also sets the data layout
+// of module to match.
+LLVMTargetMachineRef codegen_create_target_machine(LLVMModuleRef module);
+// Triple, CPU and CPU features codegen_create_target_machine picks, in one
+// string to free with free()
+char* codegen_target_description();
+// Runs a new pass manager pipeline such as default<O2> over module, tuned
+// for the host target
+bool codegen_optimize(LLVMModuleRef module, const char* passes);
+// Links objects and link_inputs into output, or into one relocatable object
+bool codegen_link(char** objects, size_t object_count, const char* output, char** link_inputs, size_t link_input_count,
+                  bool relocatable);
+// Writes module as kind. Executables are linked by the C compiler named by
+// $CC, or cc, together with link_inputs.
+bool codegen_emit(LLVMModuleRef module, CodegenOutput kind, const char* output, char** link_inputs, size_t link_input_count);
+// Maps ll, bc, asm, obj and exe to kind, returns false for anything else
+bool codegen_parse_output(const char* name, CodegenOutput* kind);
+const char* codegen_output_extension(CodegenOutput kind);
+
+// In jit.c
+// JIT compiles module and calls its main, resolving externs from the shared
+// libraries given and then the running process. Returns false if main could
+// not be run, otherwise sets exit_code to what it returned.
+bool codegen_run(LLVMModuleRef module, char** libraries, size_t library_count, int* exit_code);
+
 // In types.c
 void visit_node_program(Node* node, LLVMBuilderRef builder);
 void visit_node_variable_declaration(Node* node, LLVMBuilderRef builder);
@@ -42,3 +92,6 @@ LLVMValueRef visit_node_string_literal(Node* node, LLVMBuilderRef builder);
 LLVMValueRef visit_node_true_literal(Node* node, LLVMBuilderRef builder);
 LLVMValueRef visit_node_false_literal(Node* node, LLVMBuilderRef builder);
 LLVMValueRef visit_node_null_literal(Node* node, LLVMBuilderRef builder);
+// Converts an integer or float constant to type, other values pass through.
+// Fails the compile if that would change the value of the constant.
+LLVMValueRef codegen_fit_constant(LLVMValueRef value, LLVMTypeRef type);
@@ -6,63 +6,66 @@
 
 #include "token.h"
 
+// Zero bytes guaranteed past the end of Lexer.contents, so the scanner can
+// look ahead without checking the length first.
+#define LEXER_PADDING 64
+
+// Tokens kept around in streaming mode. Half of it is usable as lookahead,
+// the rest holds tokens the parser may still back up to.
+#define LEXER_RING_SIZE 256
+
+typedef struct LexerChunk LexerChunk;
+
 typedef struct {
     char *filename;
     char *contents;
+    size_t size;
+    size_t mapped_size;  // Length of the mapping, 0 when contents is on the heap
     size_t line;
     size_t column;
-    size_t index;
-    Token *tokens;
+    size_t position;  // Next byte of contents to lex
+    size_t index;     // Parser cursor, counted in tokens from the start of the file
+    Token *tokens;    // Every token, or a ring of LEXER_RING_SIZE when streaming
     size_t token_count;
+    size_t token_capacity;
+    bool streaming;
+    bool keep_comments;  // When false, only doc comments become tokens
+    bool encountered_equal;
+    bool in_user_defined_type;  // The next identifier names a struct, enum or union
+    LexerChunk *views;
 } Lexer;
 
-typedef enum {
-    KEYWORD_FNC = 0,
-    KEYWORD_INC,
-    KEYWORD_TRUE,
-    KEYWORD_FALSE,
-    KEYWORD_IF,
-    KEYWORD_ELIF,
-    KEYWORD_ELSE,
-    KEYWORD_WHILE,
-    KEYWORD_FOR,
-    KEYWORD_IN,
-    KEYWORD_RET,
-    KEYWORD_BRK,
-    KEYWORD_CONT,
-    KEYWORD_STRUCT,
-    KEYWORD_ENUM,
-    KEYWORD_UNION,
-    KEYWORD_PUB,
-    KEYWORD_PRV,
-    KEYWORD_CONST,
-    KEYWORD_STAT,
-    KEYWORD_AS,
-    KEYWORD_NULL,
-    KEYWORD_TOTAL,
-} KeywordType;
-
 typedef struct DataType {
     size_t id;
     const char *name;
+    uint32_t name_id;  // Interned name
     bool builtin;
 } DataType;
 
+// Names and user types go to the interner and type registry of the compiler
+// session bound to the calling thread
 Lexer *lexer_create(char *filename);
 void lexer_destroy(Lexer *lexer);
 
 Token *lexer_next_token(Lexer *lexer);
+// Like lexer_next_token, but splits ">>" outside of assignments for nested pointer types
+Token *lexer_fetch_token(Lexer *lexer);
+// Lex on demand from lexer_peek_token instead of up front with lexer_lexall
+void lexer_stream(Lexer *lexer);
 Token *lexer_peek_token(Lexer *lexer, size_t offset);
 void lexer_set_cursor(Lexer *lexer, size_t index);
 void lexer_advance_cursor(Lexer *lexer, int32_t offset);
 
 Token *lexer_create_token(Lexer *lexer, TokenType type, size_t start, size_t end);
+char *lexer_view(Lexer *lexer, size_t offset, size_t length);
+// Token.value, copied out of the source the first time it is asked for
+char *lexer_token_value(Lexer *lexer, Token *token);
+// Takes over the views of a copy of lexer that was given its own, empty list
+void lexer_merge_views(Lexer *lexer, Lexer *other);
 void lexer_lexall(Lexer *lexer, bool print);
-void lexer_print_token(Token *token);
+void lexer_print_token(Lexer *lexer, Token *token);
 void lexer_print_tokens(Lexer *lexer);
 
-void lexer_graveyard(char *token);
-
 typedef struct ASTData ASTData;
 
 char *token_type_to_string(TokenType type);
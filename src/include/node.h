@@ -1,8 +1,16 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+#include "token.h"
+#include "utils/arena.h"
+
+// Children stored in the node itself before spilling into the arena. Binary
+// expressions (lhs, operator, rhs) fit without spilling.
+#define NODE_INLINE_CHILDREN 3
+
 typedef enum {
     NODE_PROGRAM,
     NODE_VARIABLE_DECLARATION,
@@ -44,18 +52,37 @@ typedef enum {
 
 typedef struct Node Node;
 
+// 64 bytes, one cache line. Literals never have children, so their parsed
+// value shares the space of the inline children.
 typedef struct Node {
-    NodeType type;
-    void* data;
-    Node** children;
-    Node* parent;
-    size_t num_children;
-    size_t line;
-    size_t column;
+    NodeType type : 8;
+    OperatorType op : 8;  // OPERATOR_TOTAL unless type is NODE_OPERATOR
+    uint32_t id;          // Interned name of nodes naming something, INTERNER_NONE otherwise
+    uint32_t line;
+    uint32_t column;
+    uint32_t num_children;
+    uint32_t child_capacity;
+    void* data;       // Source text of the name, literal or operator
+    Node** children;  // inline_children until it outgrows them, then arena memory
+    union {
+        Node* inline_children[NODE_INLINE_CHILDREN];
+        struct {
+            union {
+                uint64_t integer;  // NODE_NUMERIC_LITERAL
+                double real;       // NODE_FLOAT_LITERAL
+            };
+            uint32_t literal_type;  // As in Token
+        };
+    };
 } Node;
 
+// Nodes created on the calling thread are allocated from this arena until
+// another one is set. The AST owns it and releases every node at once in
+// ast_destroy.
+void node_set_arena(Arena* arena);
+Arena* node_get_arena();
+
 Node* create_node(NodeType type, void* data, size_t line, size_t column);
-void destroy_node(Node* node);
 void node_add_child(Node* parent, Node* child);
 
 void print_node(Node* node, bool* indents, int indent);
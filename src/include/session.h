@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ast.h"
+#include "codegen.h"
+#include "lexer.h"
+#include "utils/build_cache.h"
+#include "utils/interner.h"
+#include "utils/type_registry.h"
+
+// What to produce from each file, shared by every session of one run
+typedef struct CompilerOptions {
+    bool keep_comments;
+    // Threads parsing the function bodies of one file once it is lexed, 0 or 1
+    // to parse while lexing
+    size_t parse_jobs;
+    CodegenOutput emit;
+    // Pass pipeline run before the module is written, NULL to run none
+    const char *passes;
+    // Threads building, optimizing and compiling the functions of one file
+    // to objects at once, for object and executable output
+    size_t codegen_jobs;
+    // Directory keeping the compiled top-level function bodies of object and
+    // executable builds, so that rebuilds only compile the bodies that changed.
+    // NULL to compile everything.
+    const char *cache_dir;
+    // Extra objects and sources passed to the linker for executables, or the
+    // shared libraries externs are looked up in when running
+    char **link_inputs;
+    size_t link_input_count;
+} CompilerOptions;
+
+// Everything one compile of one file owns. The lexer, parser and code
+// generator find it through thread-local pointers, so sessions bound to
+// different threads share nothing and can compile at the same time.
+//
+// The session is not passed to the lexer_*, ast_* and ast_to_module*
+// functions. They read the interner, type registry, AST data and node arena
+// that compiler_session_bind left on the calling thread, which keeps their
+// signatures and the many internal helpers unchanged. Calling them for a
+// session that is not bound to the thread is a bug their entry points assert.
+typedef struct CompilerSession {
+    char *filename;
+    const CompilerOptions *options;
+    Interner *interner;
+    TypeRegistry *types;
+    Lexer *lexer;
+    AST *ast;
+    BuildCache *cache;  // Set by compiler_session_parse for incremental builds
+} CompilerSession;
+
+// Creates a session for filename and binds it to the calling thread
+CompilerSession *compiler_session_create(char *filename, const CompilerOptions *options);
+void compiler_session_destroy(CompilerSession *session);
+// Makes session the one the calling thread lexes, parses and generates code for
+void compiler_session_bind(CompilerSession *session);
+
+// Lexes and parses the file. Returns false if it could not be read or has
+// errors, which are reported on stderr.
+bool compiler_session_parse(CompilerSession *session);
+// Writes a parsed session to output in the form the options ask for, in its
+// own LLVM context. Returns false if code could not be generated or the
+// output could not be written.
+bool compiler_session_emit(CompilerSession *session, const char *output, bool dump);
+
+// JIT compiles a parsed session and runs its main in this process. Returns
+// false if it could not be run, otherwise sets exit_code to what main returned.
+bool compiler_session_run(CompilerSession *session, int *exit_code);
+
+// Compiles each file to the same path with the extension of the output kind,
+// running up to jobs sessions at once. Returns false if any file failed.
+bool compiler_session_compile_all(char **filenames, size_t count, size_t jobs, const CompilerOptions *options);
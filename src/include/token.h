@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 typedef enum {
     TOKEN_EOF,
@@ -20,9 +21,95 @@ typedef enum {
     TOKEN_TOTAL,
 } TokenType;
 
+typedef enum {
+    KEYWORD_FNC = 0,
+    KEYWORD_INC,
+    KEYWORD_TRUE,
+    KEYWORD_FALSE,
+    KEYWORD_IF,
+    KEYWORD_ELIF,
+    KEYWORD_ELSE,
+    KEYWORD_WHILE,
+    KEYWORD_FOR,
+    KEYWORD_IN,
+    KEYWORD_RET,
+    KEYWORD_BRK,
+    KEYWORD_CONT,
+    KEYWORD_STRUCT,
+    KEYWORD_ENUM,
+    KEYWORD_UNION,
+    KEYWORD_PUB,
+    KEYWORD_PRV,
+    KEYWORD_CONST,
+    KEYWORD_STAT,
+    KEYWORD_AS,
+    KEYWORD_NULL,
+    KEYWORD_TOTAL,
+} KeywordType;
+
+// Multi character operators come first, in the same order as operators[]
+typedef enum {
+    OPERATOR_ELLIPSIS = 0,
+    OPERATOR_ADD_ASSIGN,
+    OPERATOR_SUB_ASSIGN,
+    OPERATOR_MUL_ASSIGN,
+    OPERATOR_DIV_ASSIGN,
+    OPERATOR_MOD_ASSIGN,
+    OPERATOR_EQ,
+    OPERATOR_NE,
+    OPERATOR_LE,
+    OPERATOR_GE,
+    OPERATOR_AND,
+    OPERATOR_OR,
+    OPERATOR_SHL,
+    OPERATOR_SHR,
+    OPERATOR_INC,
+    OPERATOR_DEC,
+    OPERATOR_DOT,
+    OPERATOR_ADD,
+    OPERATOR_SUB,
+    OPERATOR_MUL,
+    OPERATOR_DIV,
+    OPERATOR_MOD,
+    OPERATOR_ASSIGN,
+    OPERATOR_LT,
+    OPERATOR_GT,
+    OPERATOR_NOT,
+    OPERATOR_BIT_AND,
+    OPERATOR_BIT_OR,
+    OPERATOR_BIT_XOR,
+    OPERATOR_BIT_NOT,
+    OPERATOR_TOTAL,
+} OperatorType;
+
+typedef enum {
+    PUNCTUATION_LPAREN = 0,
+    PUNCTUATION_RPAREN,
+    PUNCTUATION_LBRACE,
+    PUNCTUATION_RBRACE,
+    PUNCTUATION_LBRACKET,
+    PUNCTUATION_RBRACKET,
+    PUNCTUATION_COMMA,
+    PUNCTUATION_SEMICOLON,
+    PUNCTUATION_COLON,
+    PUNCTUATION_BACKTICK,
+    PUNCTUATION_TOTAL,
+} PunctuationType;
+
 typedef struct {
     TokenType type;
-    char *value;
+    KeywordType keyword;  // KEYWORD_TOTAL unless type is TOKEN_KEYWORD
+    OperatorType op;      // OPERATOR_TOTAL unless type is TOKEN_OPERATOR
+    PunctuationType punctuation;  // PUNCTUATION_TOTAL unless type is TOKEN_PUNCTUATION
+    size_t offset;  // Start of the token in Lexer.contents
+    size_t length;
+    char *value;    // NUL-terminated text owned by the lexer, NULL until lexer_token_value for literals and comments
+    uint32_t id;    // Interned name of identifiers, keywords and types, INTERNER_NONE otherwise
+    union {
+        uint64_t integer;  // TOKEN_NUMBER
+        double real;       // TOKEN_FLOAT_NUM
+    };
+    uint32_t literal_type;  // DATA_TYPE_* named by a literal's suffix (10i64, 1.5f64), DATA_TYPE_TOTAL without one
     size_t line;
     size_t column;
     char *filename;
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+
+typedef struct ArenaChunk ArenaChunk;
+
+// Bump allocator for objects that all die together. Memory is zeroed and
+// aligned for any type, and is only released by arena_destroy.
+typedef struct Arena {
+    ArenaChunk* chunks;
+    size_t chunk_size;
+} Arena;
+
+Arena* arena_create(size_t chunk_size);
+void arena_destroy(Arena* arena);
+
+void* arena_alloc(Arena* arena, size_t size);
+// Hands every chunk of from over to into and destroys from. Memory allocated
+// from either stays valid until into is destroyed.
+void arena_merge(Arena* into, Arena* from);
@@ -1,5 +1,6 @@
 #pragma once
 #include "lexer.h"
+#include "utils/type_registry.h"
 
 typedef enum {
     DATA_TYPE_I8 = 0,
@@ -18,6 +19,7 @@ typedef enum {
 
 typedef struct Function {
     const char* name;
+    uint32_t name_id;  // Interned name
     DataType* return_type;
     const char** arguments;
     DataType** argument_types;
@@ -26,45 +28,81 @@ typedef struct Function {
 
 typedef struct Variable {
     const char* name;
+    uint32_t name_id;  // Interned name
     DataType* type;
 } Variable;
 
 typedef struct Pointer {
     const char* name;
+    uint32_t name_id;  // Interned name
     DataType* base_type;
     size_t degree;
 } Pointer;
 
 typedef struct Array {
     const char* name;
+    uint32_t name_id;  // Interned name
     DataType* base_type;
     size_t dimension;
 } Array;
 
 typedef struct Struct {
     const char* name;
+    uint32_t name_id;  // Interned name
     Variable* members;
     size_t member_count;
 } Struct;
 
+typedef struct ASTDataIndexSlot {
+    uint32_t name_id;
+    uint32_t position;  // Position in the table + 1, 0 marks a free slot
+} ASTDataIndexSlot;
+
+// Open addressing index from interned names to positions in one of the
+// ASTData tables. Of several entries with one name the earliest is found
+// first. Entries have to be removed in the reverse order they were added.
+typedef struct ASTDataIndex {
+    ASTDataIndexSlot* slots;
+    size_t slot_count;
+    size_t count;
+} ASTDataIndex;
+
 typedef struct ASTData {
-    DataType* data_types;
-    size_t data_type_count;
+    TypeRegistry* types;  // Shared with the lexer
     Function** functions;
     size_t function_count;
+    size_t function_capacity;
+    ASTDataIndex function_index;
     Variable** variables;
     size_t variable_count;
+    size_t variable_capacity;
+    ASTDataIndex variable_index;
     Pointer** pointers;
     size_t pointer_count;
+    size_t pointer_capacity;
+    ASTDataIndex pointer_index;
     Array** arrays;
     size_t array_count;
+    size_t array_capacity;
+    ASTDataIndex array_index;
     Struct** structs;
     size_t struct_count;
+    size_t struct_capacity;
+    ASTDataIndex struct_index;
 } ASTData;
 
+// Counts of each table at one point of the parse. Tables only grow while
+// parsing, so the first *_count entries are what was visible at that point.
+typedef struct ASTDataScope {
+    size_t function_count;
+    size_t struct_count;
+    size_t variable_count;
+    size_t pointer_count;
+    size_t array_count;
+} ASTDataScope;
+
 ASTData* ast_data_create();
 void ast_data_destroy(ASTData* ast_data);
-void ast_data_add_builtin_types(ASTData* ast_data);
 
 void ast_data_add_function(ASTData* ast_data, Function* function);
 void ast_data_add_variable(ASTData* ast_data, Variable* variable);
@@ -72,6 +110,24 @@ void ast_data_add_pointer(ASTData* ast_data, Pointer* pointer);
 void ast_data_add_array(ASTData* ast_data, Array* array);
 void ast_data_add_struct(ASTData* ast_data, Struct* strct);
 
+// Lookups by interned name, NULL if nothing with that name is visible
+DataType* ast_data_find_data_type(ASTData* ast_data, uint32_t name_id);
+Function* ast_data_find_function(ASTData* ast_data, uint32_t name_id);
+Variable* ast_data_find_variable(ASTData* ast_data, uint32_t name_id);
+Pointer* ast_data_find_pointer(ASTData* ast_data, uint32_t name_id);
+Array* ast_data_find_array(ASTData* ast_data, uint32_t name_id);
+Struct* ast_data_find_struct(ASTData* ast_data, uint32_t name_id);
+
+// Variables, pointers and arrays declared after scope was taken are dropped
+// by ast_data_close_scope, functions and structs stay
+ASTDataScope ast_data_open_scope(ASTData* ast_data);
+void ast_data_close_scope(ASTData* ast_data, ASTDataScope scope);
+// ast_data as it was when scope was taken. Types, functions and structs are
+// shared read-only, the name tables and their indexes are private copies that
+// can grow, so one view per thread can be parsed into at the same time.
+ASTData* ast_data_view_create(ASTData* ast_data, ASTDataScope scope);
+void ast_data_view_destroy(ASTData* view, ASTDataScope scope);
+
 void ast_data_print(ASTData* ast_data);
 
 Function* ast_data_function_create(const char* name, DataType* return_type, const char** arguments, DataType** argument_types, size_t argument_count);
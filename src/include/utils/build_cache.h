@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lexer.h"
+
+// One top-level function body of a file, in source order
+typedef struct BuildCacheEntry {
+    size_t body_start;  // Token index of the opening brace
+    uint64_t key;
+    bool cacheable;  // Declares no functions or structs
+    bool cached;     // In the object of a group an earlier build compiled
+} BuildCacheEntry;
+
+// Bodies compiled into one object. The object is only linked again while
+// every one of them is unchanged.
+typedef struct BuildCacheGroup {
+    uint64_t key;
+    char* object;
+    uint64_t* members;  // Keys of the bodies
+    size_t member_count;
+} BuildCacheGroup;
+
+// Objects of the top-level function bodies of a file, kept in a directory
+// across builds. A body is keyed by a hash of its own tokens and of every
+// token outside the cached bodies, so editing one body invalidates only that
+// one, while editing a signature, struct or global rebuilds them all. The
+// compiler and LLVM versions and the target are part of every key. Bodies
+// that declare functions or structs change what the code after them sees and
+// are never cached.
+//
+// Bodies are compiled in groups, since every module costs about as much as
+// declaring all functions of the file. A manifest per file lists the groups
+// of its last build, and committing a build deletes the objects of the groups
+// it dropped. Files sharing a directory never share groups.
+typedef struct BuildCache {
+    BuildCacheEntry* entries;
+    size_t entry_count;
+    BuildCacheGroup* groups;  // Still valid ones first, then the ones added since
+    size_t group_count;
+    size_t group_capacity;
+    uint64_t* previous;  // Groups the manifest listed before this build
+    size_t previous_count;
+    char* directory;
+    char* manifest;
+    uint64_t source;  // Hash of the file name, so files never share objects
+} BuildCache;
+
+// Hashes the tokens of a lexer lexall has run on and looks up the groups the
+// manifest of source lists in directory, creating it if needed. salt stands
+// for whatever else changes the generated code, such as the pass pipeline.
+BuildCache* build_cache_create(Lexer* lexer, const char* directory, const char* source, const char* salt);
+// Adds a group of the cacheable bodies entries[0..count) and returns where
+// its object belongs
+const char* build_cache_add_group(BuildCache* cache, const size_t* entries, size_t count);
+// Writes the groups to the manifest and deletes the objects of the groups it
+// listed before that are gone. Returns false if it could not be written.
+bool build_cache_commit(BuildCache* cache);
+void build_cache_destroy(BuildCache* cache);
@@ -3,19 +3,23 @@
 #include <llvm-c/Core.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct CodegenData_Function {
     const char* function_name;
+    uint32_t function_name_id;  // Interned function_name
     LLVMValueRef function;
     LLVMTypeRef return_type;
     LLVMTypeRef* parameter_types;
     size_t parameter_count;
     LLVMValueRef* parameters;
+    uint32_t* parameter_name_ids;  // Interned names of parameters
     bool is_vararg;
 } CodegenData_Function;
 
 typedef struct CodegenData_Variable {
     const char* variable_name;
+    uint32_t variable_name_id;  // Interned variable_name
     LLVMTypeRef variable_type;
     const char* variable_type_name;
     LLVMValueRef variable;
@@ -23,6 +27,7 @@ typedef struct CodegenData_Variable {
 
 typedef struct CodegenData_Array {
     const char* array_name;
+    uint32_t array_name_id;  // Interned array_name
     LLVMTypeRef array_type;
     LLVMTypeRef array_element_type;
     LLVMValueRef array;
@@ -31,6 +36,7 @@ typedef struct CodegenData_Array {
 
 typedef struct CodegenData_Pointer {
     const char* pointer_name;
+    uint32_t pointer_name_id;  // Interned pointer_name
     const char* pointer_base_type_name;
     LLVMTypeRef pointer_type;
     LLVMTypeRef pointer_base_type;
@@ -40,6 +46,7 @@ typedef struct CodegenData_Pointer {
 
 typedef struct CodegenData_Struct {
     const char* struct_name;
+    uint32_t struct_name_id;  // Interned struct_name
     LLVMTypeRef struct_type;
     LLVMTypeRef* struct_member_types;
     char** struct_member_type_names;
@@ -47,26 +54,67 @@ typedef struct CodegenData_Struct {
     size_t struct_member_count;
 } CodegenData_Struct;
 
+typedef enum CodegenData_SymbolKind {
+    CODEGEN_SYMBOL_PARAMETER,  // LLVMValueRef of the parameter itself
+    CODEGEN_SYMBOL_VARIABLE,
+    CODEGEN_SYMBOL_ARRAY,
+    CODEGEN_SYMBOL_POINTER,
+    CODEGEN_SYMBOL_FUNCTION,
+    CODEGEN_SYMBOL_STRUCT,
+    CODEGEN_SYMBOL_TOTAL,
+} CodegenData_SymbolKind;
+
+typedef struct CodegenData_SymbolSlot {
+    uint32_t name_id;  // INTERNER_NONE marks a free slot
+    void* value;       // NULL while nothing by that name is in scope
+} CodegenData_SymbolSlot;
+
+// Open addressing map from interned name to what the name means right now.
+// Names are not removed when they go out of scope, their value goes back to
+// whatever they shadowed.
+typedef struct CodegenData_SymbolTable {
+    CodegenData_SymbolSlot* slots;
+    size_t slot_count;
+    size_t name_count;
+} CodegenData_SymbolTable;
+
+// One name bound in a scope, undone when the scope is popped
+typedef struct CodegenData_Binding {
+    CodegenData_SymbolKind kind;
+    uint32_t name_id;
+    void* value;
+    void* shadowed;
+} CodegenData_Binding;
+
 typedef struct CodegenData {
+    // Functions and structs live as long as the module, lookups go through
+    // symbols like for everything else
     CodegenData_Function** functions;
     size_t function_count;
 
-    CodegenData_Variable** variables;
-    size_t variable_count;
-
-    CodegenData_Array** arrays;
-    size_t array_count;
-
-    CodegenData_Pointer** pointers;
-    size_t pointer_count;
-
     CodegenData_Struct** structs;
     size_t struct_count;
 
+    CodegenData_SymbolTable symbols[CODEGEN_SYMBOL_TOTAL];
+    CodegenData_Binding* bindings;  // In the order they were made
+    size_t binding_count;
+    size_t binding_capacity;
+    size_t* scopes;  // binding_count when each open scope was pushed
+    size_t scope_count;
+    size_t scope_capacity;
+
     LLVMBasicBlockRef while_merge_block;
     LLVMBasicBlockRef while_cond_block;
     CodegenData_Function* current_function;
 
+    // Top-level function bodies are dealt out round robin to partition_count
+    // modules, and this one builds those numbered partition. The others are
+    // only declared, with declare_only set while visiting them.
+    size_t partition;
+    size_t partition_count;
+    size_t body_count;
+    bool declare_only;
+
     LLVMModuleRef module;
     LLVMContextRef context;
 } CodegenData;
@@ -95,7 +143,15 @@ void codegen_data_pointer_destroy(CodegenData_Pointer* pointer);
 CodegenData_Struct* codegen_data_create_struct(const char* struct_name, LLVMTypeRef struct_type, LLVMTypeRef* struct_member_types, char** member_type_names, char** struct_member_names, size_t struct_member_count);
 void codegen_data_struct_destroy(CodegenData_Struct* strct);
 
-void codegen_data_reset_scope(CodegenData* data);
+// Scopes nest, names declared after a push are forgotten and destroyed by
+// the matching pop, and names they shadowed come back
+void codegen_data_push_scope(CodegenData* data);
+void codegen_data_pop_scope(CodegenData* data);
+// Binds the parameters of function in the current scope
+void codegen_data_add_parameters(CodegenData* data, CodegenData_Function* function);
+
+// What name_id means in the innermost scope that declares it as kind, or NULL
+void* codegen_data_lookup(CodegenData* data, CodegenData_SymbolKind kind, uint32_t name_id);
 
 CodegenData_Function* codegen_data_get_function(CodegenData* data, const char* function_name);
 CodegenData_Variable* codegen_data_get_variable(CodegenData* data, const char* variable_name);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Id 0 is never handed out, so it can mark "not an interned name"
+#define INTERNER_NONE 0
+
+typedef struct InternerChunk InternerChunk;
+
+typedef struct InternerEntry {
+    const char* string;
+    uint32_t length;
+    uint32_t hash;
+} InternerEntry;
+
+// Maps each distinct name to a stable 32-bit id. Strings are copied into
+// chunks owned by the interner and stay valid until it is destroyed.
+typedef struct Interner {
+    InternerEntry* entries;  // Indexed by id
+    size_t entry_count;
+    size_t entry_capacity;
+    uint32_t* slots;  // Open addressing table of ids, INTERNER_NONE marks a free slot
+    size_t slot_count;
+    InternerChunk* chunks;
+} Interner;
+
+// The interner of the compiler session bound to this thread
+extern _Thread_local Interner* interner;
+
+Interner* interner_create();
+void interner_destroy(Interner* interner);
+
+uint32_t interner_intern(Interner* interner, const char* string, size_t length);
+// Interns a NUL-terminated string, returning the id it already has if any.
+// Interning may move the tables, so only the lexer and session setup do it,
+// never while worker threads share the interner.
+uint32_t interner_id(Interner* interner, const char* string);
+// The id string already has, or INTERNER_NONE. Never inserts, so threads
+// sharing an interner can look names up while no one interns.
+uint32_t interner_find(Interner* interner, const char* string);
+const char* interner_string(Interner* interner, uint32_t id);
@@ -0,0 +1,5 @@
+#pragma once
+
+// Runs argv[0], searched for in PATH, with the arguments in argv (ending in
+// NULL) and waits for it. Returns its exit code, or -1 if it could not run.
+int process_run(char* const* argv);
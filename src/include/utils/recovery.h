@@ -0,0 +1,12 @@
+#pragma once
+
+#include <setjmp.h>
+
+// Where a fatal error in the lexer, parser or code generator returns to, so
+// that it fails the compile of one file instead of the whole process. Each
+// thread working on a session sets its own, NULL exits instead.
+extern _Thread_local jmp_buf* recovery_point;
+
+// Gives up on the current compile once the error has been reported, by
+// jumping to the recovery point of the calling thread
+_Noreturn void recovery_fail();
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+
+// Bulk scanners used by the lexer. All of them may read up to 32 bytes past
+// the byte they stop on, which the padding after Lexer.contents allows for,
+// and all of them stop at the terminating '\0'.
+typedef struct ScanFunctions {
+    const char *name;
+    // Skips spaces, tabs, '\r' and '\n', keeping line and column up to date
+    size_t (*whitespace)(const char *text, size_t *line, size_t *column);
+    // Length of the run of [A-Za-z0-9_-]
+    size_t (*identifier)(const char *text);
+    // Length of the run up to the first `stop` byte
+    size_t (*until)(const char *text, char stop);
+} ScanFunctions;
+
+extern ScanFunctions scan;
+
+// Picks the widest implementation the CPU supports. SYNTHEX_SCAN=scalar,
+// sse2 or avx2 in the environment overrides the choice. Call it once, before
+// any thread starts lexing.
+void scan_init();
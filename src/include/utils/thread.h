@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+typedef void (*ThreadFunction)(void* arg);
+
+typedef struct Thread {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    ThreadFunction function;
+    void* arg;
+} Thread;
+
+// Runs function(arg) on a new thread. thread must stay alive until joined.
+bool thread_start(Thread* thread, ThreadFunction function, void* arg);
+void thread_join(Thread* thread);
+// Number of CPUs available to the process, at least 1
+size_t thread_hardware_count();
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lexer.h"
+
+// Every type a file can name, built in ones first. The lexer registers user
+// types as it sees their declarations and ASTData resolves names against the
+// same registry. Types live in fixed size chunks, so a DataType* stays valid
+// however many types are added after it.
+typedef struct TypeRegistry {
+    DataType** chunks;
+    size_t chunk_count;
+    size_t count;
+    uint32_t* slots;  // Open addressing table of type ids + 1, 0 marks a free slot
+    size_t slot_count;
+} TypeRegistry;
+
+// The registry of the compiler session bound to this thread
+extern _Thread_local TypeRegistry* type_registry;
+
+TypeRegistry* type_registry_create();
+void type_registry_destroy(TypeRegistry* registry);
+
+// Registers a user type, or returns the type already registered by that name
+DataType* type_registry_add(TypeRegistry* registry, uint32_t name_id);
+DataType* type_registry_find(TypeRegistry* registry, uint32_t name_id);
+DataType* type_registry_get(TypeRegistry* registry, size_t id);
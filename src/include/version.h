@@ -0,0 +1,5 @@
+#pragma once
+
+// Raise whenever the same source compiles to different code, which also
+// invalidates everything --incremental builds have cached
+#define SYNTHEX_VERSION "0.1.0"
@@ -2,42 +2,41 @@
 #include "token.h"
 
 #include "utils/ast_data.h"
+#include "utils/interner.h"
+#include "utils/recovery.h"
+#include "utils/scan.h"
+#include "utils/type_registry.h"
 
 #include "trace.h"
 
+#include <assert.h>
 #include <ctype.h>
+#include <errno.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define array_length(array) (sizeof(array) / sizeof(array[0]))
 
-char** graveyard = NULL;
-size_t graveyard_count = 0;
-
-const char *keywords[] = {
-    "fnc",
-    "inc",
-    "true",
-    "false",
-    "if",
-    "elif",
-    "else",
-    "while",
-    "for",
-    "in",
-    "ret",
-    "brk",
-    "cont",
-    "struct",
-    "enum",
-    "union",
-    "pub",
-    "prv",
-    "const",
-    "stat",
-    "as",
-    "null",
+// Token views are carved out of large chunks instead of one allocation each
+#define LEXER_CHUNK_SIZE (64 * 1024)
+
+// Generated and hand written sources both average a little over 3 bytes per
+// token, so this sizes the token array for most files up front.
+#define LEXER_BYTES_PER_TOKEN 4
+
+struct LexerChunk {
+    LexerChunk *next;
+    size_t used;
+    size_t capacity;
+    char data[];
 };
 
 const char *types[] = {
@@ -107,58 +106,344 @@ const char *comments[] = {
     "///",
 };
 
-char user_defined_types[256][256] = {0};
-size_t user_defined_types_count = 0;
-bool in_user_defined_type = false;
+// Every token kind can be told apart by its first byte, except that '/' also
+// starts comments. The id is the single byte OperatorType or PunctuationType.
+typedef enum {
+    LEXER_CLASS_OTHER = 0,
+    LEXER_CLASS_SPACE,
+    LEXER_CLASS_IDENTIFIER,
+    LEXER_CLASS_DIGIT,
+    LEXER_CLASS_STRING,
+    LEXER_CLASS_PUNCTUATION,
+    LEXER_CLASS_OPERATOR,
+} LexerClass;
+
+typedef struct LexerDispatch {
+    uint8_t class;
+    uint8_t id;
+} LexerDispatch;
+
+static const LexerDispatch lexer_dispatch[256] = {
+    [' '] = {LEXER_CLASS_SPACE, 0},
+    ['\t'] = {LEXER_CLASS_SPACE, 0},
+    ['\n'] = {LEXER_CLASS_SPACE, 0},
+    ['\r'] = {LEXER_CLASS_SPACE, 0},
+    ['a' ... 'z'] = {LEXER_CLASS_IDENTIFIER, 0},
+    ['A' ... 'Z'] = {LEXER_CLASS_IDENTIFIER, 0},
+    ['_'] = {LEXER_CLASS_IDENTIFIER, 0},
+    ['0' ... '9'] = {LEXER_CLASS_DIGIT, 0},
+    ['"'] = {LEXER_CLASS_STRING, 0},
+    ['('] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_LPAREN},
+    [')'] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_RPAREN},
+    ['{'] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_LBRACE},
+    ['}'] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_RBRACE},
+    ['['] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_LBRACKET},
+    [']'] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_RBRACKET},
+    [','] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_COMMA},
+    [';'] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_SEMICOLON},
+    [':'] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_COLON},
+    ['`'] = {LEXER_CLASS_PUNCTUATION, PUNCTUATION_BACKTICK},
+    ['.'] = {LEXER_CLASS_OPERATOR, OPERATOR_DOT},
+    ['+'] = {LEXER_CLASS_OPERATOR, OPERATOR_ADD},
+    ['-'] = {LEXER_CLASS_OPERATOR, OPERATOR_SUB},
+    ['*'] = {LEXER_CLASS_OPERATOR, OPERATOR_MUL},
+    ['/'] = {LEXER_CLASS_OPERATOR, OPERATOR_DIV},
+    ['%'] = {LEXER_CLASS_OPERATOR, OPERATOR_MOD},
+    ['='] = {LEXER_CLASS_OPERATOR, OPERATOR_ASSIGN},
+    ['<'] = {LEXER_CLASS_OPERATOR, OPERATOR_LT},
+    ['>'] = {LEXER_CLASS_OPERATOR, OPERATOR_GT},
+    ['!'] = {LEXER_CLASS_OPERATOR, OPERATOR_NOT},
+    ['&'] = {LEXER_CLASS_OPERATOR, OPERATOR_BIT_AND},
+    ['|'] = {LEXER_CLASS_OPERATOR, OPERATOR_BIT_OR},
+    ['^'] = {LEXER_CLASS_OPERATOR, OPERATOR_BIT_XOR},
+    ['~'] = {LEXER_CLASS_OPERATOR, OPERATOR_BIT_NOT},
+};
+
+// Transitions of the operator DFA. States are OperatorType values plus ".."
+// which only exists on the way to "..."; entries are offset by one so that 0
+// means no transition. The lexer keeps the longest accepting state it saw.
+#define OPERATOR_STATE_DOT_DOT OPERATOR_TOTAL
+#define OPERATOR_STATE_COUNT (OPERATOR_TOTAL + 1)
+
+static const uint8_t operator_transitions[OPERATOR_STATE_COUNT][128] = {
+    [OPERATOR_DOT]['.'] = OPERATOR_STATE_DOT_DOT + 1,
+    [OPERATOR_STATE_DOT_DOT]['.'] = OPERATOR_ELLIPSIS + 1,
+    [OPERATOR_ADD]['='] = OPERATOR_ADD_ASSIGN + 1,
+    [OPERATOR_ADD]['+'] = OPERATOR_INC + 1,
+    [OPERATOR_SUB]['='] = OPERATOR_SUB_ASSIGN + 1,
+    [OPERATOR_SUB]['-'] = OPERATOR_DEC + 1,
+    [OPERATOR_MUL]['='] = OPERATOR_MUL_ASSIGN + 1,
+    [OPERATOR_DIV]['='] = OPERATOR_DIV_ASSIGN + 1,
+    [OPERATOR_MOD]['='] = OPERATOR_MOD_ASSIGN + 1,
+    [OPERATOR_ASSIGN]['='] = OPERATOR_EQ + 1,
+    [OPERATOR_NOT]['='] = OPERATOR_NE + 1,
+    [OPERATOR_LT]['='] = OPERATOR_LE + 1,
+    [OPERATOR_LT]['<'] = OPERATOR_SHL + 1,
+    [OPERATOR_GT]['='] = OPERATOR_GE + 1,
+    [OPERATOR_GT]['>'] = OPERATOR_SHR + 1,
+    [OPERATOR_BIT_AND]['&'] = OPERATOR_AND + 1,
+    [OPERATOR_BIT_OR]['|'] = OPERATOR_OR + 1,
+};
+
+// Keywords and builtin type names share one perfect hash table. The hash only
+// looks at the first two bytes, the last byte and the length; the multipliers
+// were searched offline so that no two reserved words collide. A collision
+// introduced by a new word shows up as an initializer override warning.
+#define RESERVED_HASH(first, second, last, length) (((first) * 13 + (second) * 10 + (last) + (length) * 14) & 63)
+
+typedef struct ReservedWord {
+    const char *word;
+    size_t length;
+    TokenType type;
+    uint32_t id;  // KeywordType for keywords, BuiltInDataTypes for types
+} ReservedWord;
+
+static const ReservedWord reserved_words[64] = {
+    [RESERVED_HASH('f', 'n', 'c', 3)] = {"fnc", 3, TOKEN_KEYWORD, KEYWORD_FNC},
+    [RESERVED_HASH('i', 'n', 'c', 3)] = {"inc", 3, TOKEN_KEYWORD, KEYWORD_INC},
+    [RESERVED_HASH('t', 'r', 'e', 4)] = {"true", 4, TOKEN_KEYWORD, KEYWORD_TRUE},
+    [RESERVED_HASH('f', 'a', 'e', 5)] = {"false", 5, TOKEN_KEYWORD, KEYWORD_FALSE},
+    [RESERVED_HASH('i', 'f', 'f', 2)] = {"if", 2, TOKEN_KEYWORD, KEYWORD_IF},
+    [RESERVED_HASH('e', 'l', 'f', 4)] = {"elif", 4, TOKEN_KEYWORD, KEYWORD_ELIF},
+    [RESERVED_HASH('e', 'l', 'e', 4)] = {"else", 4, TOKEN_KEYWORD, KEYWORD_ELSE},
+    [RESERVED_HASH('w', 'h', 'e', 5)] = {"while", 5, TOKEN_KEYWORD, KEYWORD_WHILE},
+    [RESERVED_HASH('f', 'o', 'r', 3)] = {"for", 3, TOKEN_KEYWORD, KEYWORD_FOR},
+    [RESERVED_HASH('i', 'n', 'n', 2)] = {"in", 2, TOKEN_KEYWORD, KEYWORD_IN},
+    [RESERVED_HASH('r', 'e', 't', 3)] = {"ret", 3, TOKEN_KEYWORD, KEYWORD_RET},
+    [RESERVED_HASH('b', 'r', 'k', 3)] = {"brk", 3, TOKEN_KEYWORD, KEYWORD_BRK},
+    [RESERVED_HASH('c', 'o', 't', 4)] = {"cont", 4, TOKEN_KEYWORD, KEYWORD_CONT},
+    [RESERVED_HASH('s', 't', 't', 6)] = {"struct", 6, TOKEN_KEYWORD, KEYWORD_STRUCT},
+    [RESERVED_HASH('e', 'n', 'm', 4)] = {"enum", 4, TOKEN_KEYWORD, KEYWORD_ENUM},
+    [RESERVED_HASH('u', 'n', 'n', 5)] = {"union", 5, TOKEN_KEYWORD, KEYWORD_UNION},
+    [RESERVED_HASH('p', 'u', 'b', 3)] = {"pub", 3, TOKEN_KEYWORD, KEYWORD_PUB},
+    [RESERVED_HASH('p', 'r', 'v', 3)] = {"prv", 3, TOKEN_KEYWORD, KEYWORD_PRV},
+    [RESERVED_HASH('c', 'o', 't', 5)] = {"const", 5, TOKEN_KEYWORD, KEYWORD_CONST},
+    [RESERVED_HASH('s', 't', 't', 4)] = {"stat", 4, TOKEN_KEYWORD, KEYWORD_STAT},
+    [RESERVED_HASH('a', 's', 's', 2)] = {"as", 2, TOKEN_KEYWORD, KEYWORD_AS},
+    [RESERVED_HASH('n', 'u', 'l', 4)] = {"null", 4, TOKEN_KEYWORD, KEYWORD_NULL},
+    [RESERVED_HASH('i', '8', '8', 2)] = {"i8", 2, TOKEN_TYPEANNOTATION, DATA_TYPE_I8},
+    [RESERVED_HASH('i', '1', '6', 3)] = {"i16", 3, TOKEN_TYPEANNOTATION, DATA_TYPE_I16},
+    [RESERVED_HASH('i', '3', '2', 3)] = {"i32", 3, TOKEN_TYPEANNOTATION, DATA_TYPE_I32},
+    [RESERVED_HASH('i', '6', '4', 3)] = {"i64", 3, TOKEN_TYPEANNOTATION, DATA_TYPE_I64},
+    [RESERVED_HASH('f', '3', '2', 3)] = {"f32", 3, TOKEN_TYPEANNOTATION, DATA_TYPE_F32},
+    [RESERVED_HASH('f', '6', '4', 3)] = {"f64", 3, TOKEN_TYPEANNOTATION, DATA_TYPE_F64},
+    [RESERVED_HASH('s', 't', 'r', 3)] = {"str", 3, TOKEN_TYPEANNOTATION, DATA_TYPE_STR},
+    [RESERVED_HASH('c', 'h', 'r', 3)] = {"chr", 3, TOKEN_TYPEANNOTATION, DATA_TYPE_CHR},
+    [RESERVED_HASH('b', 'l', 'n', 3)] = {"bln", 3, TOKEN_TYPEANNOTATION, DATA_TYPE_BLN},
+    [RESERVED_HASH('v', 'o', 'd', 4)] = {"void", 4, TOKEN_TYPEANNOTATION, DATA_TYPE_VOID},
+    [RESERVED_HASH('p', 't', 'r', 3)] = {"ptr", 3, TOKEN_TYPEANNOTATION, DATA_TYPE_PTR},
+};
 
-const size_t KEYWORD_COUNT = array_length(keywords);
-const size_t BUILTIN_TYPE_COUNT = array_length(types);
-const size_t OPERATOR_COUNT = array_length(operators);
-const size_t PUNCTUATION_COUNT = array_length(punctuation);
 const size_t COMMENT_COUNT = array_length(comments);
 
+static const ReservedWord *lexer_find_reserved(const char *word, size_t length) {
+    if (length < 2) {
+        return NULL;
+    }
+    const unsigned char *w = (const unsigned char *)word;
+    const ReservedWord *reserved = &reserved_words[RESERVED_HASH(w[0], w[1], w[length - 1], length)];
+    if (reserved->length == length && memcmp(reserved->word, word, length) == 0) {
+        return reserved;
+    }
+    return NULL;
+}
+
+// Returns the length of the longest operator at text, 0 if there is none
+static size_t lexer_match_operator(const char *text, OperatorType *op) {
+    const unsigned char *t = (const unsigned char *)text;
+    if (lexer_dispatch[t[0]].class != LEXER_CLASS_OPERATOR) {
+        return 0;
+    }
+    size_t state = lexer_dispatch[t[0]].id;
+    size_t length = 1;
+    *op = state;
+    for (size_t i = 1; t[i] < 128 && operator_transitions[state][t[i]] != 0; i++) {
+        state = operator_transitions[state][t[i]] - 1;
+        if (state != OPERATOR_STATE_DOT_DOT) {
+            *op = state;
+            length = i + 1;
+        }
+    }
+    return length;
+}
+
+// Turns newlines and tabs into spaces, drops them at both ends and collapses
+// runs of them, rewriting the NUL-terminated text in place in one pass
+static void lexer_normalize_comment(char *text) {
+    size_t length = 0;
+    bool pending_space = false;
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == ' ' || *c == '\n' || *c == '\t') {
+            pending_space = length > 0;
+            continue;
+        }
+        if (pending_space) {
+            text[length++] = ' ';
+            pending_space = false;
+        }
+        text[length++] = *c;
+    }
+    text[length] = '\0';
+}
+
+// Reads a file we cannot map (stdin, pipes) into a growing heap buffer.
+static bool lexer_read_stream(Lexer *lexer, FILE *file) {
+    size_t capacity = 4096;
+    size_t size = 0;
+    char *contents = malloc(capacity + LEXER_PADDING);
+    while (true) {
+        size_t read = fread(contents + size, sizeof(char), capacity - size, file);
+        size += read;
+        if (read == 0) {
+            break;
+        }
+        if (size == capacity) {
+            capacity *= 2;
+            contents = realloc(contents, capacity + LEXER_PADDING);
+        }
+    }
+    if (ferror(file)) {
+        free(contents);
+        return false;
+    }
+    memset(contents + size, 0, LEXER_PADDING);
+    lexer->contents = contents;
+    lexer->size = size;
+    lexer->mapped_size = 0;
+    return true;
+}
+
+#ifndef _WIN32
+// Maps the file read-only and places a zeroed page right after it. The kernel
+// zero-fills the tail of the last file page, so contents[size] is always '\0'
+// and there is at least one page of padding to read into.
+static bool lexer_map_file(Lexer *lexer, int fd, size_t size) {
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t mapped_size = (size + page_size - 1) / page_size * page_size + page_size;
+
+    char *contents = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (contents == MAP_FAILED) {
+        return false;
+    }
+    if (size > 0 && mmap(contents, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(contents, mapped_size);
+        return false;
+    }
+    madvise(contents, size, MADV_SEQUENTIAL);
+
+    lexer->contents = contents;
+    lexer->size = size;
+    lexer->mapped_size = mapped_size;
+    return true;
+}
+#endif
+
+static bool lexer_load(Lexer *lexer, char *filename) {
+    if (strcmp(filename, "-") == 0) {
+        lexer->filename = "<stdin>";
+        return lexer_read_stream(lexer, stdin);
+    }
+
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && lexer_map_file(lexer, fd, st.st_size)) {
+        close(fd);
+        return true;
+    }
+    close(fd);
+#endif
+
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    bool loaded = lexer_read_stream(lexer, file);
+    fclose(file);
+    return loaded;
+}
+
 Lexer *lexer_create(char *filename) {
     Lexer *lexer = malloc(sizeof(Lexer));
     lexer->filename = filename;
     lexer->line = 1;
     lexer->column = 1;
+    lexer->position = 0;
     lexer->index = 0;
+    lexer->in_user_defined_type = false;
 
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
+    if (!lexer_load(lexer, filename)) {
         printf("Error: Could not open file %s\n", filename);
+        free(lexer);
         return NULL;
     }
 
-    fseek(file, 0, SEEK_END);
-    size_t size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    lexer->contents = malloc((size + 1) * sizeof(char));
-    fread(lexer->contents, sizeof(char), size, file);
-    fclose(file);
-
-    lexer->tokens = NULL;
     lexer->token_count = 0;
+    lexer->token_capacity = lexer->size / LEXER_BYTES_PER_TOKEN + 16;
+    lexer->tokens = malloc(lexer->token_capacity * sizeof(Token));
+    lexer->streaming = false;
+    lexer->keep_comments = true;
+    lexer->encountered_equal = false;
+    lexer->views = NULL;
 
     return lexer;
 }
 
 void lexer_destroy(Lexer *lexer) {
+#ifndef _WIN32
+    if (lexer->mapped_size > 0) {
+        munmap(lexer->contents, lexer->mapped_size);
+    } else {
+        free(lexer->contents);
+    }
+#else
     free(lexer->contents);
+#endif
+    LexerChunk *chunk = lexer->views;
+    while (chunk != NULL) {
+        LexerChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
     free(lexer->tokens);
     free(lexer);
+}
 
-    for (size_t i = 0; i < graveyard_count; i++) {
-        free(graveyard[i]);
+void lexer_stream(Lexer *lexer) {
+    assert(interner != NULL && type_registry != NULL && "No compiler session bound to this thread");
+    free(lexer->tokens);
+    lexer->tokens = malloc(LEXER_RING_SIZE * sizeof(Token));
+    lexer->token_capacity = LEXER_RING_SIZE;
+    lexer->streaming = true;
+}
+
+static Token *lexer_token_at(Lexer *lexer, size_t index) {
+    if (lexer->streaming) {
+        return &lexer->tokens[index & (LEXER_RING_SIZE - 1)];
     }
-    graveyard_count = 0;
-    graveyard = NULL;
+    return &lexer->tokens[index];
 }
 
 Token *lexer_peek_token(Lexer *lexer, size_t offset) {
-    Token *token = &(lexer->tokens[lexer->index + offset]);
-    return token;
+    size_t index = lexer->index + offset;
+    if (!lexer->streaming) {
+        return lexer_token_at(lexer, index);
+    }
+    if (offset >= LEXER_RING_SIZE / 2) {
+        fprintf(stderr, "Error: Cannot look %zu tokens ahead while streaming\n", offset);
+        recovery_fail();
+    }
+    while (lexer->token_count <= index) {
+        lexer_fetch_token(lexer);
+    }
+    if (index + LEXER_RING_SIZE <= lexer->token_count) {
+        fprintf(stderr, "Error: Token %zu is no longer buffered\n", index);
+        recovery_fail();
+    }
+    return lexer_token_at(lexer, index);
 }
 
 void lexer_set_cursor(Lexer *lexer, size_t index) {
@@ -169,31 +454,121 @@ void lexer_advance_cursor(Lexer *lexer, int32_t offset) {
     lexer->index += offset;
 }
 
-Token *lexer_create_token(Lexer *lexer, TokenType type, size_t start, size_t end) {
-    if (lexer->token_count == 0) {
-        lexer->tokens = calloc(1, sizeof(Token));
+char *lexer_view(Lexer *lexer, size_t offset, size_t length) {
+    LexerChunk *chunk = lexer->views;
+    if (chunk == NULL || chunk->capacity - chunk->used < length + 1) {
+        size_t capacity = length + 1 > LEXER_CHUNK_SIZE ? length + 1 : LEXER_CHUNK_SIZE;
+        chunk = malloc(sizeof(LexerChunk) + capacity);
+        chunk->next = lexer->views;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        lexer->views = chunk;
+    }
+    char *view = chunk->data + chunk->used;
+    memcpy(view, lexer->contents + offset, length);
+    view[length] = '\0';
+    chunk->used += length + 1;
+    return view;
+}
+
+char *lexer_token_value(Lexer *lexer, Token *token) {
+    if (token->value == NULL) {
+        token->value = lexer_view(lexer, token->offset, token->length);
+        if (token->type == TOKEN_COMMENT) {
+            lexer_normalize_comment(token->value);
+        }
+    }
+    return token->value;
+}
+
+void lexer_merge_views(Lexer *lexer, Lexer *other) {
+    LexerChunk *chunk = other->views;
+    while (chunk != NULL) {
+        LexerChunk *next = chunk->next;
+        chunk->next = lexer->views;
+        lexer->views = chunk;
+        chunk = next;
+    }
+    other->views = NULL;
+}
+
+// Consumes a suffix naming a numeric type right after the digits of a
+// literal and returns its DATA_TYPE_*, or DATA_TYPE_TOTAL if there is none
+static uint32_t lexer_literal_suffix(Lexer *lexer) {
+    const char *suffix = lexer->contents + lexer->position;
+    for (uint32_t type = DATA_TYPE_I8; type <= DATA_TYPE_F64; type++) {
+        size_t length = strlen(types[type]);
+        unsigned char next = suffix[length];
+        if (strncmp(suffix, types[type], length) == 0 && lexer_dispatch[next].class != LEXER_CLASS_IDENTIFIER &&
+            lexer_dispatch[next].class != LEXER_CLASS_DIGIT) {
+            lexer->position += length;
+            lexer->column += length;
+            return type;
+        }
+    }
+    return DATA_TYPE_TOTAL;
+}
+
+// Parsed once here, codegen only picks the width. Number tokens are short,
+// so the digits are copied to the stack rather than into a view.
+static void lexer_parse_number(Lexer *lexer, Token *token) {
+    char digits[64];
+    const char *text = digits;
+    if (token->length < sizeof(digits)) {
+        memcpy(digits, lexer->contents + token->offset, token->length);
+        digits[token->length] = '\0';
     } else {
-        lexer->tokens = realloc(lexer->tokens, (lexer->token_count + 1) * sizeof(Token));
+        text = lexer_token_value(lexer, token);
+    }
+    if (token->type == TOKEN_FLOAT_NUM) {
+        token->real = strtod(text, NULL);
+        return;
+    }
+    // There are no unsigned types, so anything past INT64_MAX would only wrap
+    errno = 0;
+    token->integer = strtoull(text, NULL, 10);
+    if (errno == ERANGE || token->integer > INT64_MAX) {
+        fprintf(stderr, "Error: %s:%zu: Integer literal %s does not fit in i64\n", lexer->filename, lexer->line, text);
+        recovery_fail();
     }
-    Token *token = &lexer->tokens[lexer->token_count++];
+}
+
+Token *lexer_create_token(Lexer *lexer, TokenType type, size_t start, size_t end) {
+    if (!lexer->streaming && lexer->token_count == lexer->token_capacity) {
+        lexer->token_capacity *= 2;
+        lexer->tokens = realloc(lexer->tokens, lexer->token_capacity * sizeof(Token));
+    }
+    Token *token = lexer_token_at(lexer, lexer->token_count++);
     token->type = type;
-    token->value = calloc(end - start + 1, sizeof(char));
-    memcpy(token->value, lexer->contents + start, end - start);
-    token->value[end - start] = '\0';
+    token->offset = start;
+    token->length = end - start;
+    // Names share the interner's copy. Operators and punctuation get their
+    // spelling from the caller, the rest is copied by lexer_token_value.
+    if (type == TOKEN_IDENTIFIER || type == TOKEN_KEYWORD || type == TOKEN_TYPEANNOTATION || type == TOKEN_TYPEDECLARATION) {
+        token->id = interner_intern(interner, lexer->contents + start, end - start);
+        token->value = (char *)interner_string(interner, token->id);
+    } else {
+        token->id = INTERNER_NONE;
+        token->value = NULL;
+    }
+    token->keyword = KEYWORD_TOTAL;
+    token->op = OPERATOR_TOTAL;
+    token->literal_type = DATA_TYPE_TOTAL;
+    token->punctuation = PUNCTUATION_TOTAL;
     token->line = lexer->line;
     token->column = lexer->column;
     token->filename = lexer->filename;
     return token;
 }
 
-void lexer_print_token(Token *token) {
-    printf("Token: %s Value: %s\n", token_type_to_string(token->type), token->value);
+void lexer_print_token(Lexer *lexer, Token *token) {
+    printf("Token: %s Value: %s\n", token_type_to_string(token->type), lexer_token_value(lexer, token));
 }
 
 void lexer_print_tokens(Lexer *lexer) {
     Token *token = NULL;
     while ((token = lexer_next_token(lexer))->type != TOKEN_EOF) {
-        lexer_print_token(token);
+        lexer_print_token(lexer, token);
     }
 }
 
@@ -232,224 +607,214 @@ char *token_type_to_string(TokenType type) {
 
 Token *lexer_next_token(Lexer *lexer) {
     char c;
-    while ((c = lexer->contents[lexer->index]) != '\0') {
+    while ((c = lexer->contents[lexer->position]) != '\0') {
+        const LexerDispatch *dispatch = &lexer_dispatch[(unsigned char)c];
+
         // Skip whitespaces
-        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-            lexer->index++;
-            if (c == '\n') {
-                lexer->line++;
-                lexer->column = 1;
-            } else if (c == '\t') {
-                lexer->column += 4;
-            } else {
-                lexer->column++;
-            }
+        if (dispatch->class == LEXER_CLASS_SPACE) {
+            lexer->position += scan.whitespace(&lexer->contents[lexer->position], &lexer->line, &lexer->column);
             continue;
         }
 
-        if (isalpha(c) || c == '_') {
-            size_t start = lexer->index;
-            while (isalpha(lexer->contents[lexer->index]) || isdigit(lexer->contents[lexer->index]) || lexer->contents[lexer->index] == '_' || lexer->contents[lexer->index] == '-') {
-                lexer->index++;
-                lexer->column++;
-            }
-            if (in_user_defined_type) {
-                snprintf(user_defined_types[user_defined_types_count], lexer->index - start + 1, "%s", &lexer->contents[start]);
-                user_defined_types_count++;
-
-                in_user_defined_type = false;
-                Token* tok = lexer_create_token(lexer, TOKEN_TYPEDECLARATION, start, lexer->index);
+        if (dispatch->class == LEXER_CLASS_IDENTIFIER) {
+            size_t start = lexer->position;
+            size_t body = scan.identifier(&lexer->contents[lexer->position]);
+            lexer->position += body;
+            lexer->column += body;
+            const char *word = &lexer->contents[start];
+            size_t length = lexer->position - start;
+            if (lexer->in_user_defined_type) {
+                lexer->in_user_defined_type = false;
+                Token* tok = lexer_create_token(lexer, TOKEN_TYPEDECLARATION, start, lexer->position);
+                type_registry_add(type_registry, tok->id);
                 return tok;
             }
 
-            // Match user defined types
-            Token* tok = lexer_create_token(lexer, TOKEN_IDENTIFIER, start, lexer->index);
-
-            for (size_t i = 0; i < user_defined_types_count; i++) {
-                if (strcmp(tok->value, user_defined_types[i]) == 0) {
-                    tok->type = TOKEN_TYPEANNOTATION;
-                    break;
-                }
-            }
-
-            // Match keywords
-            for (uint32_t i = 0; i < KEYWORD_COUNT; i++) {
-                if (strcmp(tok->value, keywords[i]) == 0) {
-                    tok->type = TOKEN_KEYWORD;
-                    if (strcmp(tok->value, "struct") == 0 || strcmp(tok->value, "enum") == 0 || strcmp(tok->value, "union") == 0) {
-                        in_user_defined_type = true;
+            const ReservedWord *reserved = lexer_find_reserved(word, length);
+            if (reserved != NULL) {
+                Token* tok = lexer_create_token(lexer, reserved->type, start, lexer->position);
+                if (reserved->type == TOKEN_KEYWORD) {
+                    tok->keyword = reserved->id;
+                    if (tok->keyword == KEYWORD_STRUCT || tok->keyword == KEYWORD_ENUM || tok->keyword == KEYWORD_UNION) {
+                        lexer->in_user_defined_type = true;
                     }
-                    break;
                 }
+                return tok;
             }
 
-            // Match types
-            for (uint32_t i = 0; i < BUILTIN_TYPE_COUNT; i++) {
-                if (strcmp(tok->value, types[i]) == 0) {
-                    tok->type = TOKEN_TYPEANNOTATION;
-                    break;
-                }
+            // Match user defined types
+            Token* tok = lexer_create_token(lexer, TOKEN_IDENTIFIER, start, lexer->position);
+            if (type_registry_find(type_registry, tok->id) != NULL) {
+                tok->type = TOKEN_TYPEANNOTATION;
             }
             return tok;
         }
 
-        if (isdigit(c)) {
-            size_t start = lexer->index;
+        if (dispatch->class == LEXER_CLASS_DIGIT) {
+            size_t start = lexer->position;
             TokenType type = TOKEN_NUMBER;
-            while (isdigit(lexer->contents[lexer->index]) || lexer->contents[lexer->index] == '.') {
-                lexer->index++;
-                if (lexer->contents[lexer->index] == '.') {
+            while (isdigit(lexer->contents[lexer->position]) || lexer->contents[lexer->position] == '.') {
+                lexer->position++;
+                if (lexer->contents[lexer->position] == '.') {
                     type = TOKEN_FLOAT_NUM;
-                    lexer->index++;
+                    lexer->position++;
                     lexer->column++;
                 }
             }
-            return lexer_create_token(lexer, type, start, lexer->index);
+            uint32_t literal_type = lexer_literal_suffix(lexer);
+            if (literal_type == DATA_TYPE_F32 || literal_type == DATA_TYPE_F64) {
+                type = TOKEN_FLOAT_NUM;
+            } else if (literal_type != DATA_TYPE_TOTAL && type == TOKEN_FLOAT_NUM) {
+                fprintf(stderr, "Error: %s:%zu: Float literal %.*s has an integer suffix\n", lexer->filename, lexer->line,
+                        (int)(lexer->position - start), lexer->contents + start);
+                recovery_fail();
+            }
+
+            Token *token = lexer_create_token(lexer, type, start, lexer->position);
+            token->literal_type = literal_type;
+            lexer_parse_number(lexer, token);
+            return token;
         }
 
-        if (c == '\"') {
-            size_t start = lexer->index++;
-            while (lexer->contents[lexer->index] != '\"') {
-                lexer->index++;
+        if (dispatch->class == LEXER_CLASS_STRING) {
+            size_t start = lexer->position++;
+            size_t body = scan.until(&lexer->contents[lexer->position], '\"');
+            lexer->position += body;
+            lexer->column += body;
+            if (lexer->contents[lexer->position] == '\"') {
+                lexer->position++;
                 lexer->column++;
             }
-            lexer->index++;
-            lexer->column++;
-            return lexer_create_token(lexer, TOKEN_STRING, start, lexer->index);
+            return lexer_create_token(lexer, TOKEN_STRING, start, lexer->position);
         }
 
-        // Match punctuation
-        for (uint32_t i = 0; i < PUNCTUATION_COUNT; i++) {
-            if (c == punctuation[i][0]) {
-                lexer->index++;
-                lexer->column++;
-                return lexer_create_token(lexer, TOKEN_PUNCTUATION, lexer->index - 1, lexer->index);
-            }
+        if (dispatch->class == LEXER_CLASS_PUNCTUATION) {
+            lexer->position++;
+            lexer->column++;
+            Token *token = lexer_create_token(lexer, TOKEN_PUNCTUATION, lexer->position - 1, lexer->position);
+            token->punctuation = dispatch->id;
+            token->value = (char *)punctuation[dispatch->id];
+            return token;
         }
 
-        if (c == '/' && lexer->contents[lexer->index + 1] == '/' && lexer->contents[lexer->index + 2] == '/') {
-            size_t start = lexer->index + 3;
-            while (lexer->contents[lexer->index] != '\n') {
-                lexer->index++;
-                lexer->column++;
-            }
-            return lexer_create_token(lexer, TOKEN_DOC_COMMENT, start, lexer->index);
+        if (c == '/' && lexer->contents[lexer->position + 1] == '/' && lexer->contents[lexer->position + 2] == '/') {
+            size_t start = lexer->position + 3;
+            size_t body = scan.until(&lexer->contents[lexer->position], '\n');
+            lexer->position += body;
+            lexer->column += body;
+            return lexer_create_token(lexer, TOKEN_DOC_COMMENT, start, lexer->position);
         }
 
-        if (c == '/' && lexer->contents[lexer->index + 1] == '/') {
-            size_t start = lexer->index + 2;
-            while (lexer->contents[lexer->index] != '\n') {
-                lexer->index++;
-                lexer->column++;
+        if (c == '/' && lexer->contents[lexer->position + 1] == '/') {
+            size_t start = lexer->position + 2;
+            size_t body = scan.until(&lexer->contents[lexer->position], '\n');
+            lexer->position += body;
+            lexer->column += body;
+            if (!lexer->keep_comments) {
+                continue;
             }
-            return lexer_create_token(lexer, TOKEN_COMMENT, start, lexer->index);
+            return lexer_create_token(lexer, TOKEN_COMMENT, start, lexer->position);
         }
 
-        if (c == '/' && lexer->contents[lexer->index + 1] == '*') {
-            size_t start = lexer->index + 2;
-            while (lexer->contents[lexer->index] != '*' || lexer->contents[lexer->index + 1] != '/') {
-                lexer->index++;
-                lexer->column++;
-            }
-            lexer->index += 2;
+        if (c == '/' && lexer->contents[lexer->position + 1] == '*') {
+            lexer->position += 2;
             lexer->column += 2;
-            Token *token = lexer_create_token(lexer, TOKEN_COMMENT, start, lexer->index - 2);
-            // Replace all newlines with spaces
-            for (size_t i = 0; i < strlen(token->value); i++) {
-                if (token->value[i] == '\n') {
-                    token->value[i] = ' ';
+            size_t start = lexer->position;
+            while ((c = lexer->contents[lexer->position]) != '\0') {
+                if (c == '*' && lexer->contents[lexer->position + 1] == '/') {
+                    break;
                 }
-            }
-            // Replace all tabs with spaces
-            for (size_t i = 0; i < strlen(token->value); i++) {
-                if (token->value[i] == '\t') {
-                    token->value[i] = ' ';
+                if (c == '\n') {
+                    lexer->line++;
+                    lexer->column = 1;
+                } else {
+                    lexer->column++;
                 }
+                lexer->position++;
             }
-            // Remove all spaces at the beginning of the comment
-            while (token->value[0] == ' ') {
-                token->value++;
+            size_t end = lexer->position;
+            if (c != '\0') {
+                lexer->position += 2;
+                lexer->column += 2;
             }
-            // Remove all spaces at the end of the comment
-            while (token->value[strlen(token->value) - 1] == ' ') {
-                token->value[strlen(token->value) - 1] = '\0';
+            if (!lexer->keep_comments) {
+                continue;
             }
-            // Remove all more than 1 space in a row
-            for (size_t i = 0; i < strlen(token->value); i++) {
-                while (token->value[i] == ' ' && token->value[i + 1] == ' ') {
-                    memmove(&token->value[i], &token->value[i + 1], strlen(token->value) - i);
-                }
-            }
-            return token;
+            return lexer_create_token(lexer, TOKEN_COMMENT, start, end);
         }
 
-        // Match operators
-        for (uint32_t i = 0; i < OPERATOR_COUNT; i++) {
-            if (strncmp(&lexer->contents[lexer->index], operators[i], strlen(operators[i])) == 0) {
-                lexer->index += strlen(operators[i]);
-                lexer->column += strlen(operators[i]);
-                return lexer_create_token(lexer, TOKEN_OPERATOR, lexer->index - strlen(operators[i]), lexer->index);
-            }
+        OperatorType op;
+        size_t length = lexer_match_operator(&lexer->contents[lexer->position], &op);
+        if (length > 0) {
+            lexer->position += length;
+            lexer->column += length;
+            Token *token = lexer_create_token(lexer, TOKEN_OPERATOR, lexer->position - length, lexer->position);
+            token->op = op;
+            token->value = (char *)operators[op];
+            return token;
         }
 
-        lexer->index++;
+        lexer->position++;
         lexer->column++;
     }
 
-    return lexer_create_token(lexer, TOKEN_EOF, lexer->index, lexer->index);
+    return lexer_create_token(lexer, TOKEN_EOF, lexer->position, lexer->position);
+}
+
+Token *lexer_fetch_token(Lexer *lexer) {
+    Token *token = lexer_next_token(lexer);
+    size_t index = lexer->token_count - 1;
+    // Fix ">>" operator
+    if (token->op == OPERATOR_ASSIGN) {
+        lexer->encountered_equal = true;
+    }
+    if (token->punctuation == PUNCTUATION_SEMICOLON || token->punctuation == PUNCTUATION_LBRACE ||
+        token->punctuation == PUNCTUATION_RBRACE) {
+        lexer->encountered_equal = false;
+    }
+    if (!lexer->encountered_equal) {
+        if (token->op == OPERATOR_SHR) {
+            token->type = TOKEN_OPERATOR;
+            token->value = ">";
+            token->op = OPERATOR_GT;
+            // Add another token ">"
+            Token *token2 = lexer_create_token(lexer, TOKEN_OPERATOR, lexer->position, lexer->position);
+            token2->type = TOKEN_OPERATOR;
+            token2->value = ">";
+            token2->op = OPERATOR_GT;
+            // Growing the token array may have moved the first half
+            token = lexer_token_at(lexer, index);
+        }
+    }
+    return token;
 }
 
 void lexer_lexall(Lexer *lexer, bool print) {
+    assert(interner != NULL && type_registry != NULL && "No compiler session bound to this thread");
     Token *token = NULL;
-    bool encountered_equal = false;
-    while ((token = lexer_next_token(lexer))->type != TOKEN_EOF) {
+    while ((token = lexer_fetch_token(lexer))->type != TOKEN_EOF) {
         if (print) {
-            lexer_print_token(token);
-        }
-        // Fix ">>" operator
-        if (token->type == TOKEN_OPERATOR && strcmp(token->value, "=") == 0) {
-            encountered_equal = true;
-        }
-        if (token->type == TOKEN_PUNCTUATION) {
-            if (strcmp(token->value, ";") == 0 || strcmp(token->value, "{") == 0 || strcmp(token->value, "}") == 0) {
-                encountered_equal = false;
-            }
-        }
-        if (!encountered_equal) {
-            if (token->type == TOKEN_OPERATOR && strcmp(token->value, ">>") == 0) {
-                token->type = TOKEN_OPERATOR;
-                token->value = ">";
-                // Add another token ">"
-                Token *token2 = lexer_create_token(lexer, TOKEN_OPERATOR, lexer->index, lexer->index);
-                token2->type = TOKEN_OPERATOR;
-                token2->value = ">";
-            }
+            lexer_print_token(lexer, token);
         }
     }
 }
 
 DataType* get_data_type(const char *type_str, ASTData *data) {
-    for (size_t i = 0; i < data->data_type_count; i++) {
-        if (strcmp(type_str, data->data_types[i].name) == 0) {
-            return &data->data_types[i];
-        }
+    DataType *type = ast_data_find_data_type(data, interner_find(interner, type_str));
+    if (type != NULL) {
+        return type;
     }
     print_trace();
     fprintf(stderr, "Error: Type %s not found\n", type_str);
-    exit(1);
+    recovery_fail();
 }
 
 KeywordType get_keyword_type(const char *keyword_str) {
-    for (int i = 0; i < KEYWORD_TOTAL; i++) {
-        if (strcmp(keyword_str, keywords[i]) == 0) {
-            return i;
-        }
+    const ReservedWord *reserved = lexer_find_reserved(keyword_str, strlen(keyword_str));
+    if (reserved != NULL && reserved->type == TOKEN_KEYWORD) {
+        return reserved->id;
     }
 
     return KEYWORD_TOTAL;
 }
 
-void lexer_graveyard(char *token) {
-    graveyard = realloc(graveyard, (graveyard_count + 1) * sizeof(char*));
-    graveyard[graveyard_count++] = token;
-}
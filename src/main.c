@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 
@@ -6,11 +7,14 @@
 #include "trace.h"
 
 #include "tests.h"
+#include "bench.h"
 
 #include "ast.h"
 #include "codegen.h"
-#include "lexer.h"
+#include "session.h"
 #include "utils/ast_data.h"
+#include "utils/scan.h"
+#include "utils/thread.h"
 
 void sigsegv_handler(int signum) {
     printf("Caught segfault %d\n", signum);
@@ -21,54 +25,132 @@ void sigsegv_handler(int signum) {
 
 int main(int argc, char *argv[]) {
     signal(SIGSEGV, sigsegv_handler);
-    if (argc != 4) {
-        printf("Usage: %s <filename> -o <output>\n", argv[0]);
-        return 1;
+    scan_init();
+    codegen_init_native_target();
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        if (argc >= 3 && strcmp(argv[2], "gen") == 0) {
+            if (argc != 6) {
+                printf("Usage: %s bench gen <functions|nesting|expressions|structs> <count> <output>\n", argv[0]);
+                return 1;
+            }
+            return bench_generate(argv[3], strtoul(argv[4], NULL, 10), argv[5]) ? 0 : 1;
+        } else if (argc >= 3) {
+            bench_file(argv[2], argc > 3 ? strtoul(argv[3], NULL, 10) : 20);
+        } else {
+            bench_suite(5);
+        }
+        return 0;
     }
 
-    if (strcmp(argv[1], "test") == 0) {
+    if (argc >= 2 && strcmp(argv[1], "test") == 0) {
         test_all();
         return 0;
     }
 
-    char* filename = argv[1];
-    Lexer *lexer = lexer_create(filename);
-    if (lexer == NULL) {
-        printf("Failed to create lexer\n");
-        return 1;
+    char** filenames = malloc(sizeof(char*) * argc);
+    size_t file_count = 0;
+    char* ll_filename = NULL;
+    CompilerOptions options = {.keep_comments = true, .emit = CODEGEN_OUTPUT_IR};
+    options.link_inputs = malloc(sizeof(char*) * argc);
+    bool batch = false;
+    size_t jobs = 0;
+    // run compiles the file in memory and executes it instead of writing it
+    bool run = argc >= 2 && strcmp(argv[1], "run") == 0;
+    for (int i = run ? 2 : 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            ll_filename = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            batch = true;
+            jobs = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--strip-comments") == 0) {
+            options.keep_comments = false;
+        } else if (strncmp(argv[i], "--emit=", 7) == 0) {
+            if (!codegen_parse_output(argv[i] + 7, &options.emit)) {
+                printf("Unknown output kind %s, expected ll, bc, asm, obj or exe\n", argv[i] + 7);
+                free(options.link_inputs);
+                free(filenames);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-O0") == 0) {
+            options.passes = "default<O0>";
+        } else if (strcmp(argv[i], "-O1") == 0) {
+            options.passes = "default<O1>";
+        } else if (strcmp(argv[i], "-O2") == 0) {
+            options.passes = "default<O2>";
+        } else if (strcmp(argv[i], "-O3") == 0) {
+            options.passes = "default<O3>";
+        } else if (strcmp(argv[i], "--codegen-jobs") == 0 && i + 1 < argc) {
+            options.codegen_jobs = strtoul(argv[++i], NULL, 10);
+            if (options.codegen_jobs == 0) {
+                options.codegen_jobs = thread_hardware_count();
+            }
+        } else if (strcmp(argv[i], "--parse-jobs") == 0 && i + 1 < argc) {
+            options.parse_jobs = strtoul(argv[++i], NULL, 10);
+            if (options.parse_jobs == 0) {
+                options.parse_jobs = thread_hardware_count();
+            }
+        } else if (strcmp(argv[i], "--incremental") == 0 && i + 1 < argc) {
+            options.cache_dir = argv[++i];
+        } else if (strncmp(argv[i], "--passes=", 9) == 0) {
+            options.passes = argv[i] + 9;
+        } else if (strcmp(argv[i], "--link") == 0 && i + 1 < argc) {
+            options.link_inputs[options.link_input_count++] = argv[++i];
+        } else {
+            filenames[file_count++] = argv[i];
+        }
     }
-    // lexer_print_tokens(lexer);
-
-    AST *ast = ast_create();
-    ast_build(ast, lexer);
-    ast_print(ast);
-    ast_data_print(ast->data);
-    // ast_print_declarations();
-
 
-    // Find the index where the argument is "-o"
-    int index = -1;
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(argv[i], "-o") == 0) {
-            index = i;
-            break;
+    // Every file gets its own session and lands next to its source
+    if (batch && file_count > 0 && ll_filename == NULL) {
+        if (jobs == 0) {
+            jobs = thread_hardware_count();
+        }
+        bool compiled = compiler_session_compile_all(filenames, file_count, jobs, &options);
+        free(options.link_inputs);
+        free(filenames);
+        return compiled ? 0 : 1;
+    }
+    if (run && !batch && file_count == 1 && ll_filename == NULL) {
+        CompilerSession *session = compiler_session_create(filenames[0], &options);
+        free(filenames);
+        int exit_code = 1;
+        if (!compiler_session_parse(session)) {
+            printf("Failed to create lexer\n");
+        } else if (!compiler_session_run(session, &exit_code)) {
+            exit_code = 1;
         }
+        compiler_session_destroy(session);
+        free(options.link_inputs);
+        return exit_code;
     }
-    if (index == -1) {
-        printf("Usage: %s <filename> -o <output>\n", argv[0]);
+    if (run || batch || file_count != 1 || ll_filename == NULL) {
+        printf("Usage: %s <filename> -o <output> [options]\n", argv[0]);
+        printf("       %s -j <jobs> <filename>... [options]\n", argv[0]);
+        printf("       %s run <filename> [options]\n", argv[0]);
+        printf("Options: --strip-comments, --emit=<ll|bc|asm|obj|exe>, --link <file>, -O<0-3>, --passes=<pipeline>,\n");
+        printf("         --codegen-jobs <jobs>, --parse-jobs <jobs>, --incremental <cache-dir>\n");
+        free(options.link_inputs);
+        free(filenames);
         return 1;
     }
 
-    // Get the filename after "-o"
-    char* ll_filename = argv[index+1];
-    if (ll_filename == NULL) {
-        printf("Usage: %s <filename> -o <output>\n", argv[0]);
+    CompilerSession *session = compiler_session_create(filenames[0], &options);
+    free(filenames);
+    if (!compiler_session_parse(session)) {
+        printf("Failed to create lexer\n");
+        compiler_session_destroy(session);
+        free(options.link_inputs);
         return 1;
     }
+    // lexer_print_tokens(session->lexer);
+
+    ast_print(session->ast);
+    ast_data_print(session->ast->data);
+    // ast_print_declarations();
 
-    ast_to_llvm(ast, lexer->filename, ll_filename, true);
+    bool emitted = compiler_session_emit(session, ll_filename, true);
 
-    ast_destroy(ast);
-    lexer_destroy(lexer);
-    return 0;
+    compiler_session_destroy(session);
+    free(options.link_inputs);
+    return emitted ? 0 : 1;
 }
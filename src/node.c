@@ -2,8 +2,12 @@
 
 #include <locale.h>
 #include <stdio.h>
+#include <string.h>
 #include <wchar.h>
 
+#include "utils/interner.h"
+#include "utils/recovery.h"
+
 #ifndef NOCOLOR
 #define ANSI_COLOR_RED "\x1b[31m"
 #define ANSI_COLOR_GREEN "\x1b[32m"
@@ -16,30 +20,65 @@
 #define ANSI_COLOR_RESET ""
 #endif
 
+// Per thread, so that threads parsing separate functions never share one
+static _Thread_local Arena* node_arena = NULL;
+
+void node_set_arena(Arena* arena) {
+    node_arena = arena;
+}
+
+Arena* node_get_arena() {
+    return node_arena;
+}
+
 Node* create_node(NodeType type, void* data, size_t line, size_t column) {
-    Node* node = calloc(1, sizeof(Node));
+    Node* node = arena_alloc(node_arena, sizeof(Node));
     node->type = type;
+    node->op = OPERATOR_TOTAL;
     node->data = data;
-    node->children = NULL;
+    node->children = node->inline_children;
     node->num_children = 0;
+    node->child_capacity = NODE_INLINE_CHILDREN;
     node->line = line;
     node->column = column;
-    return node;
-}
-
-void destroy_node(Node* node) {
-    for (size_t i = 0; i < node->num_children; i++) {
-        destroy_node(node->children[i]);
+    if (data == NULL) {
+        return node;
+    }
+    switch (type) {
+        case NODE_NUMERIC_LITERAL:
+        case NODE_FLOAT_LITERAL:
+            // The value is stored where the children would be
+            node->child_capacity = 0;
+            break;
+        case NODE_STRING_LITERAL:
+        case NODE_TRUE_LITERAL:
+        case NODE_FALSE_LITERAL:
+        case NODE_NULL_LITERAL:
+        case NODE_OPERATOR:
+        case NODE_COMMENT:
+        case NODE_DOC_COMMENT:
+            break;
+        default:
+            node->id = interner_find(interner, data);
+            break;
     }
-    free(node->children);
-    free(node);
+    return node;
 }
 
 void node_add_child(Node* parent, Node* child) {
-    parent->num_children++;
-    parent->children = realloc(parent->children, parent->num_children * sizeof(Node*));
-    parent->children[parent->num_children - 1] = child;
-    child->parent = parent;
+    if (parent->child_capacity == 0) {
+        fprintf(stderr, "Error: %s can not have children\n", node_type_to_string(parent->type));
+        recovery_fail();
+    }
+    if (parent->num_children == parent->child_capacity) {
+        // The old array stays behind in the arena, doubling keeps that waste
+        // below the size of the final array
+        Node** children = arena_alloc(node_arena, parent->child_capacity * 2 * sizeof(Node*));
+        memcpy(children, parent->children, parent->num_children * sizeof(Node*));
+        parent->children = children;
+        parent->child_capacity *= 2;
+    }
+    parent->children[parent->num_children++] = child;
 }
 
 void print_node(Node* node, bool* indents, int indent) {
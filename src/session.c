@@ -0,0 +1,419 @@
+#include "session.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "codegen.h"
+#include "node.h"
+#include "utils/recovery.h"
+#include "utils/thread.h"
+
+extern _Thread_local ASTData *ast_data;
+
+// The bodies an incremental build compiles are split into groups of this
+// many, but into no more than COMPILER_SESSION_GROUPS unless --codegen-jobs
+// asks for more. Every module costs about as much as declaring all functions
+// of the file, so few groups keep the first build as fast as a plain one,
+// while smaller ones rebuild less after an edit.
+#define COMPILER_SESSION_GROUP_BODIES 256
+#define COMPILER_SESSION_GROUPS 8
+
+typedef struct CompilerSessionWorker {
+    Thread thread;
+    char **filenames;
+    size_t count;
+    const CompilerOptions *options;
+    atomic_size_t *next_file;
+    atomic_bool *failed;
+} CompilerSessionWorker;
+
+// Builds, optimizes and compiles partitions of the functions of a file, taking
+// the next one until none are left
+typedef struct CompilerSessionCodegenWorker {
+    Thread thread;
+    CompilerSession *session;
+    char **objects;  // Where each partition is written
+    size_t partition_count;
+    atomic_size_t *next_partition;
+    atomic_bool *failed;
+} CompilerSessionCodegenWorker;
+
+CompilerSession *compiler_session_create(char *filename, const CompilerOptions *options) {
+    CompilerSession *session = calloc(1, sizeof(CompilerSession));
+    session->filename = filename;
+    session->options = options;
+    session->interner = interner_create();
+    // The registry interns the built in type names as it is created
+    interner = session->interner;
+    session->types = type_registry_create();
+    compiler_session_bind(session);
+    return session;
+}
+
+void compiler_session_destroy(CompilerSession *session) {
+    if (session->cache != NULL) {
+        build_cache_destroy(session->cache);
+    }
+    if (session->ast != NULL) {
+        ast_destroy(session->ast);
+    }
+    if (session->lexer != NULL) {
+        lexer_destroy(session->lexer);
+    }
+    type_registry_destroy(session->types);
+    interner_destroy(session->interner);
+    if (interner == session->interner) {
+        interner = NULL;
+        type_registry = NULL;
+        ast_data = NULL;
+    }
+    free(session);
+}
+
+void compiler_session_bind(CompilerSession *session) {
+    interner = session->interner;
+    type_registry = session->types;
+    if (session->ast != NULL) {
+        node_set_arena(session->ast->arena);
+        ast_data = session->ast->data;
+    }
+}
+
+// Cached bodies are not needed to build the others, so the parser skips them
+static void compiler_session_parse_incremental(CompilerSession *session) {
+    lexer_lexall(session->lexer, false);
+    BuildCache *cache = build_cache_create(session->lexer, session->options->cache_dir, session->filename,
+                                           session->options->passes != NULL ? session->options->passes : "");
+    size_t *skipped = malloc(cache->entry_count * sizeof(size_t));
+    size_t skipped_count = 0;
+    for (size_t i = 0; i < cache->entry_count; i++) {
+        if (cache->entries[i].cached) {
+            skipped[skipped_count++] = cache->entries[i].body_start;
+        }
+    }
+    ast_build_lexed(session->ast, session->lexer, session->options->parse_jobs, skipped, skipped_count);
+    free(skipped);
+    // Files without bodies are built as usual
+    if (cache->entry_count == 0) {
+        build_cache_destroy(cache);
+    } else {
+        session->cache = cache;
+    }
+}
+
+static bool compiler_session_parse_file(CompilerSession *session) {
+    session->lexer = lexer_create(session->filename);
+    if (session->lexer == NULL) {
+        return false;
+    }
+    session->lexer->keep_comments = session->options->keep_comments;
+    session->ast = ast_create();
+    const CompilerOptions *options = session->options;
+    if (options->cache_dir != NULL &&
+        (options->emit == CODEGEN_OUTPUT_OBJECT || options->emit == CODEGEN_OUTPUT_EXECUTABLE)) {
+        compiler_session_parse_incremental(session);
+    } else if (options->parse_jobs > 1) {
+        ast_build_parallel(session->ast, session->lexer, options->parse_jobs);
+    } else {
+        ast_build(session->ast, session->lexer);
+    }
+    return true;
+}
+
+bool compiler_session_parse(CompilerSession *session) {
+    jmp_buf recovery;
+    jmp_buf *outer = recovery_point;
+    if (setjmp(recovery) != 0) {
+        recovery_point = outer;
+        return false;
+    }
+    recovery_point = &recovery;
+    bool parsed = compiler_session_parse_file(session);
+    recovery_point = outer;
+    return parsed;
+}
+
+// Returns false if the partition could not be compiled, after reporting why
+static bool compiler_session_compile_partition(CompilerSessionCodegenWorker *worker, size_t partition) {
+    CompilerSession *session = worker->session;
+    const char *passes = session->options->passes;
+    jmp_buf recovery;
+    if (setjmp(recovery) != 0) {
+        recovery_point = NULL;
+        return false;
+    }
+    recovery_point = &recovery;
+    LLVMModuleRef module =
+        ast_to_module_partition(session->ast, session->lexer->filename, partition, worker->partition_count);
+    recovery_point = NULL;
+    bool compiled = passes == NULL || codegen_optimize(module, passes);
+    compiled = compiled && codegen_emit(module, CODEGEN_OUTPUT_OBJECT, worker->objects[partition], NULL, 0);
+    codegen_destroy_module(module);
+    return compiled;
+}
+
+static void compiler_session_codegen_worker(void *arg) {
+    CompilerSessionCodegenWorker *worker = arg;
+    compiler_session_bind(worker->session);
+    while (!atomic_load(worker->failed)) {
+        size_t partition = atomic_fetch_add(worker->next_partition, 1);
+        if (partition >= worker->partition_count) {
+            break;
+        }
+        if (!compiler_session_compile_partition(worker, partition)) {
+            atomic_store(worker->failed, true);
+        }
+    }
+}
+
+// Compiles partition i of the functions of the session to objects[i], on up
+// to jobs threads. Returns false if any partition failed.
+static bool compiler_session_compile_partitions(CompilerSession *session, char **objects, size_t count, size_t jobs) {
+    atomic_size_t next_partition = 0;
+    atomic_bool failed = false;
+    size_t worker_count = jobs < count ? jobs : count;
+    if (worker_count == 0) {
+        worker_count = 1;
+    }
+    CompilerSessionCodegenWorker *workers = calloc(worker_count, sizeof(CompilerSessionCodegenWorker));
+    for (size_t i = 0; i < worker_count; i++) {
+        workers[i].session = session;
+        workers[i].objects = objects;
+        workers[i].partition_count = count;
+        workers[i].next_partition = &next_partition;
+        workers[i].failed = &failed;
+        if (!thread_start(&workers[i].thread, compiler_session_codegen_worker, &workers[i])) {
+            fprintf(stderr, "Error: Could not start code generator thread\n");
+            exit(1);
+        }
+    }
+    for (size_t i = 0; i < worker_count; i++) {
+        thread_join(&workers[i].thread);
+    }
+    free(workers);
+    return !atomic_load(&failed);
+}
+
+// Links objects into the output the options ask for
+static bool compiler_session_link(CompilerSession *session, char **objects, size_t count, const char *output) {
+    const CompilerOptions *options = session->options;
+    bool executable = options->emit == CODEGEN_OUTPUT_EXECUTABLE;
+    return codegen_link(objects, count, output, executable ? options->link_inputs : NULL,
+                        executable ? options->link_input_count : 0, !executable);
+}
+
+// Splits the functions over codegen_jobs modules, each in an LLVM context of
+// its own, and links the objects they compile to. Functions in different
+// partitions are optimized separately, so calls between them are not inlined.
+static bool compiler_session_emit_parallel(CompilerSession *session, const char *output) {
+    size_t count = session->options->codegen_jobs;
+    const char *extension = codegen_output_extension(CODEGEN_OUTPUT_OBJECT);
+    char **objects = calloc(count, sizeof(char *));
+    for (size_t i = 0; i < count; i++) {
+        size_t length = strlen(output) + strlen(extension) + 24;
+        objects[i] = malloc(length);
+        snprintf(objects[i], length, "%s.%zu%s", output, i, extension);
+    }
+    bool compiled = compiler_session_compile_partitions(session, objects, count, count) &&
+                    compiler_session_link(session, objects, count, output);
+    for (size_t i = 0; i < count; i++) {
+        remove(objects[i]);
+        free(objects[i]);
+    }
+    free(objects);
+    return compiled;
+}
+
+// Compiles the bodies that are not cached and links them with the cached
+// groups. The tree only holds the bodies that were not cached, in source
+// order, and they are dealt out to partitions like --codegen-jobs does. Each
+// partition becomes a group of the cache, written next to its place in the
+// cache and renamed into it once complete. Partitions holding a body that
+// can not be cached are compiled next to the output and removed after
+// linking.
+static bool compiler_session_emit_incremental(CompilerSession *session, const char *output) {
+    BuildCache *cache = session->cache;
+    size_t *misses = malloc((cache->entry_count + 1) * sizeof(size_t));
+    size_t miss_count = 0;
+    for (size_t i = 0; i < cache->entry_count; i++) {
+        if (!cache->entries[i].cached) {
+            misses[miss_count++] = i;
+        }
+    }
+    size_t jobs = session->options->codegen_jobs > 0 ? session->options->codegen_jobs : 1;
+    size_t count = (miss_count + COMPILER_SESSION_GROUP_BODIES - 1) / COMPILER_SESSION_GROUP_BODIES;
+    count = count < COMPILER_SESSION_GROUPS ? count : COMPILER_SESSION_GROUPS;
+    count = count > jobs ? count : jobs;
+    count = count < miss_count ? count : miss_count;
+
+    // Cached groups first, then the partitions of this build
+    size_t cached_count = cache->group_count;
+    size_t object_count = cached_count + count;
+    char **objects = calloc(object_count + 1, sizeof(char *));
+    bool *stored = calloc(count + 1, sizeof(bool));
+    size_t *members = malloc((miss_count + 1) * sizeof(size_t));
+    const char *extension = codegen_output_extension(CODEGEN_OUTPUT_OBJECT);
+    for (size_t i = 0; i < cached_count; i++) {
+        objects[i] = strdup(cache->groups[i].object);
+    }
+    for (size_t partition = 0; partition < count; partition++) {
+        size_t member_count = 0;
+        stored[partition] = true;
+        for (size_t i = partition; i < miss_count; i += count) {
+            members[member_count++] = misses[i];
+            stored[partition] = stored[partition] && cache->entries[misses[i]].cacheable;
+        }
+        const char *object = stored[partition] ? build_cache_add_group(cache, members, member_count) : output;
+        size_t length = strlen(object) + strlen(extension) + 24;
+        objects[cached_count + partition] = malloc(length);
+        snprintf(objects[cached_count + partition], length, "%s.%zu%s", object, partition,
+                 stored[partition] ? ".tmp" : extension);
+    }
+
+    bool compiled = compiler_session_compile_partitions(session, objects + cached_count, count, jobs);
+    for (size_t partition = 0, group = cached_count; partition < count; partition++) {
+        if (!stored[partition]) {
+            continue;
+        }
+        const char *object = cache->groups[group++].object;
+        if (compiled && rename(objects[cached_count + partition], object) == 0) {
+            free(objects[cached_count + partition]);
+            objects[cached_count + partition] = strdup(object);
+            continue;
+        } else if (compiled) {
+            fprintf(stderr, "Error: Could not store %s in the cache\n", object);
+            compiled = false;
+        }
+        stored[partition] = false;
+    }
+    // The new groups stay in the cache even if linking fails
+    compiled = compiled && build_cache_commit(cache);
+    compiled = compiled && compiler_session_link(session, objects, object_count, output);
+    for (size_t i = 0; i < object_count; i++) {
+        if (i >= cached_count && !stored[i - cached_count]) {
+            remove(objects[i]);
+        }
+        free(objects[i]);
+    }
+    free(members);
+    free(stored);
+    free(objects);
+    free(misses);
+    return compiled;
+}
+
+static bool compiler_session_emit_file(CompilerSession *session, const char *output, bool dump) {
+    const CompilerOptions *options = session->options;
+    if (session->cache != NULL) {
+        return compiler_session_emit_incremental(session, output);
+    }
+    if (options->codegen_jobs > 1 &&
+        (options->emit == CODEGEN_OUTPUT_OBJECT || options->emit == CODEGEN_OUTPUT_EXECUTABLE)) {
+        return compiler_session_emit_parallel(session, output);
+    }
+    LLVMModuleRef module = ast_to_module(session->ast, session->lexer->filename, dump);
+    bool emitted = options->passes == NULL || codegen_optimize(module, options->passes);
+    emitted = emitted && codegen_emit(module, options->emit, output, options->link_inputs, options->link_input_count);
+    codegen_destroy_module(module);
+    return emitted;
+}
+
+bool compiler_session_emit(CompilerSession *session, const char *output, bool dump) {
+    jmp_buf recovery;
+    jmp_buf *outer = recovery_point;
+    if (setjmp(recovery) != 0) {
+        recovery_point = outer;
+        return false;
+    }
+    recovery_point = &recovery;
+    bool emitted = compiler_session_emit_file(session, output, dump);
+    recovery_point = outer;
+    return emitted;
+}
+
+bool compiler_session_run(CompilerSession *session, int *exit_code) {
+    const CompilerOptions *options = session->options;
+    jmp_buf recovery;
+    jmp_buf *outer = recovery_point;
+    if (setjmp(recovery) != 0) {
+        recovery_point = outer;
+        return false;
+    }
+    recovery_point = &recovery;
+    LLVMModuleRef module = ast_to_module(session->ast, session->lexer->filename, false);
+    recovery_point = outer;
+    bool ran = options->passes == NULL || codegen_optimize(module, options->passes);
+    ran = ran && codegen_run(module, options->link_inputs, options->link_input_count, exit_code);
+    codegen_destroy_module(module);
+    return ran;
+}
+
+// foo.syn becomes foo.ll for IR, names without that extension get it appended
+static char *compiler_session_output_name(const char *filename, CodegenOutput kind) {
+    const char *extension = codegen_output_extension(kind);
+    size_t length = strlen(filename);
+    if (length > 4 && strcmp(filename + length - 4, ".syn") == 0) {
+        length -= 4;
+    }
+    char *output = malloc(length + strlen(extension) + 1);
+    memcpy(output, filename, length);
+    strcpy(output + length, extension);
+    return output;
+}
+
+static void compiler_session_worker(void *arg) {
+    CompilerSessionWorker *worker = arg;
+    while (true) {
+        size_t index = atomic_fetch_add(worker->next_file, 1);
+        if (index >= worker->count) {
+            break;
+        }
+        CompilerSession *session = compiler_session_create(worker->filenames[index], worker->options);
+        if (compiler_session_parse(session)) {
+            char *output = compiler_session_output_name(session->filename, worker->options->emit);
+            if (!compiler_session_emit(session, output, false)) {
+                atomic_store(worker->failed, true);
+            }
+            free(output);
+        } else {
+            atomic_store(worker->failed, true);
+        }
+        compiler_session_destroy(session);
+    }
+}
+
+bool compiler_session_compile_all(char **filenames, size_t count, size_t jobs, const CompilerOptions *options) {
+    atomic_size_t next_file = 0;
+    atomic_bool failed = false;
+    size_t worker_count = jobs < count ? jobs : count;
+    if (worker_count == 0) {
+        worker_count = 1;
+    }
+    CompilerSessionWorker *workers = calloc(worker_count, sizeof(CompilerSessionWorker));
+    for (size_t i = 0; i < worker_count; i++) {
+        workers[i].filenames = filenames;
+        workers[i].count = count;
+        workers[i].options = options;
+        workers[i].next_file = &next_file;
+        workers[i].failed = &failed;
+    }
+
+    // A single job runs on the calling thread
+    if (worker_count == 1) {
+        compiler_session_worker(&workers[0]);
+    } else {
+        for (size_t i = 0; i < worker_count; i++) {
+            if (!thread_start(&workers[i].thread, compiler_session_worker, &workers[i])) {
+                fprintf(stderr, "Error: Could not start compiler thread\n");
+                exit(1);
+            }
+        }
+        for (size_t i = 0; i < worker_count; i++) {
+            thread_join(&workers[i].thread);
+        }
+    }
+    free(workers);
+    return !atomic_load(&failed);
+}
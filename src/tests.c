@@ -1,24 +1,44 @@
 #include "tests.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <dirent.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/wait.h>
 
-#include "ast.h"
-#include "codegen.h"
-#include "lexer.h"
+#include "session.h"
+#include "utils/process.h"
+#include "utils/scan.h"
 
 #define ANSI_COLOR_RED     "\x1b[31m"
 #define ANSI_COLOR_GREEN   "\x1b[32m"
 #define ANSI_COLOR_YELLOW  "\x1b[33m"
 #define ANSI_COLOR_RESET   "\x1b[0m"
 
+// Where test_file keeps the objects of its incremental builds
+#define TEST_CACHE_DIR "t_cache"
+// tests/t.c as a shared library, for programs run in process
+#define TEST_LIBRARY "./t.so"
+// Marks a statement in a test case that must not compile, see test_errors
+#define TEST_ERROR_MARKER "// error: "
+#define TEST_ERROR_FILE "t_error.syn"
+
 int test_file(char *filename, char* expected_filename);
+int test_parse_jobs(char *filename);
+int test_errors(char *filename);
+int test_scanners(char *filename);
+// Builds filename into ./t with options, or runs it in process like the run
+// subcommand, and compares what it prints with expected_filename
+static int test_program(char *filename, char *expected_filename, const CompilerOptions *options, bool run);
 
 void test_all() {
     printf("%sRunning all tests%s\n", ANSI_COLOR_YELLOW, ANSI_COLOR_RESET);
+    char *compiler = getenv("CC") != NULL ? getenv("CC") : "cc";
+    char *library_argv[] = {compiler, "-shared", "-fPIC", "-o", TEST_LIBRARY, "tests/t.c", NULL};
+    if (process_run(library_argv) != 0) {
+        fprintf(stderr, "%sERROR:%s Failed to build %s\n", ANSI_COLOR_RED, ANSI_COLOR_RESET, TEST_LIBRARY);
+    }
     // Get all files in the tests directory
     DIR *dir;
     struct dirent *ent;
@@ -48,23 +68,219 @@ void test_all() {
     }
 
     // Cleanup
-    system("rm test.ll");
-    system("rm t");
+    remove("t");
+    remove(TEST_LIBRARY);
+    remove("t.ll");
+    remove("t_jobs.ll");
+    remove(TEST_ERROR_FILE);
+    if ((dir = opendir(TEST_CACHE_DIR)) != NULL) {
+        while ((ent = readdir(dir)) != NULL) {
+            char object[512];
+            snprintf(object, sizeof(object), "%s/%s", TEST_CACHE_DIR, ent->d_name);
+            remove(object);
+        }
+        closedir(dir);
+        remove(TEST_CACHE_DIR);
+    }
+}
+
+// Writes the IR of filename, parsed with parse_jobs threads, to output
+static bool test_emit_ir(char *filename, size_t parse_jobs, const char *output) {
+    CompilerOptions options = {.keep_comments = true, .parse_jobs = parse_jobs, .emit = CODEGEN_OUTPUT_IR};
+    CompilerSession *session = compiler_session_create(filename, &options);
+    bool emitted = compiler_session_parse(session) && compiler_session_emit(session, output, false);
+    compiler_session_destroy(session);
+    return emitted;
+}
+
+// Reads all of filename, NULL if it can not be read
+static char *test_read_file(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *contents = malloc(size + 1);
+    size_t len = fread(contents, sizeof(char), size, file);
+    contents[len] = '\0';
+    fclose(file);
+    return contents;
+}
+
+// Parsing function bodies on threads has to give the same module as parsing
+// them in order
+int test_parse_jobs(char *filename) {
+    if (!test_emit_ir(filename, 1, "t.ll") || !test_emit_ir(filename, 2, "t_jobs.ll")) {
+        fprintf(stderr, "%sERROR:%s Failed to write the IR of %s\n", ANSI_COLOR_RED, ANSI_COLOR_RESET, filename);
+        return -1;
+    }
+    char *serial = test_read_file("t.ll");
+    char *parallel = test_read_file("t_jobs.ll");
+    bool same = serial != NULL && parallel != NULL && strcmp(serial, parallel) == 0;
+    free(serial);
+    free(parallel);
+    if (!same) {
+        fprintf(stderr, "%sERROR:%s IR differs when parsed with --parse-jobs 2\n", ANSI_COLOR_RED, ANSI_COLOR_RESET);
+        return -1;
+    }
+    return 0;
+}
+
+// Each line of filename starting with TEST_ERROR_MARKER holds a statement
+// that is compiled on its own as the body of main and has to be rejected
+int test_errors(char *filename) {
+    char *contents = test_read_file(filename);
+    if (contents == NULL) {
+        return -1;
+    }
+    int result = 0;
+    size_t marker_length = strlen(TEST_ERROR_MARKER);
+    for (char *line = contents; line != NULL && *line != '\0'; line = strchr(line, '\n')) {
+        line += *line == '\n';
+        line += strspn(line, " \t");
+        if (strncmp(line, TEST_ERROR_MARKER, marker_length) != 0) {
+            continue;
+        }
+        char *statement = line + marker_length;
+        int length = (int)strcspn(statement, "\n");
+        FILE *file = fopen(TEST_ERROR_FILE, "w");
+        if (file == NULL) {
+            result = -1;
+            break;
+        }
+        fprintf(file, "fnc main() : i32 {\n\t%.*s\n\tret 0;\n}\n", length, statement);
+        fclose(file);
+        if (test_emit_ir(TEST_ERROR_FILE, 1, "t.ll")) {
+            fprintf(stderr, "%sERROR:%s Compiled although it should not: %.*s\n", ANSI_COLOR_RED, ANSI_COLOR_RESET, length,
+                    statement);
+            result = -1;
+        }
+    }
+    free(contents);
+    return result;
+}
+
+// Whether two lexers made the same tokens, apart from where their text lives
+static bool test_same_tokens(Lexer *a, Lexer *b) {
+    if (a->token_count != b->token_count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->token_count; i++) {
+        Token *x = &a->tokens[i];
+        Token *y = &b->tokens[i];
+        if (x->type != y->type || x->keyword != y->keyword || x->op != y->op || x->punctuation != y->punctuation ||
+            x->offset != y->offset || x->length != y->length || x->id != y->id || x->literal_type != y->literal_type ||
+            x->line != y->line || x->column != y->column) {
+            return false;
+        }
+        // Only numbers set the parsed value
+        if ((x->type == TOKEN_NUMBER && x->integer != y->integer) || (x->type == TOKEN_FLOAT_NUM && x->real != y->real)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Lexes filename with every scanner SYNTHEX_SCAN can pick and compares the
+// tokens with those of the scalar one. Scanners the CPU lacks are skipped.
+int test_scanners(char *filename) {
+    const char *scanners[] = {"scalar", "sse2", "avx2"};
+    const size_t scanner_count = sizeof(scanners) / sizeof(scanners[0]);
+    char *forced = getenv("SYNTHEX_SCAN") != NULL ? strdup(getenv("SYNTHEX_SCAN")) : NULL;
+    CompilerOptions options = {.keep_comments = true};
+    CompilerSession *sessions[sizeof(scanners) / sizeof(scanners[0])] = {NULL};
+    int result = 0;
+    for (size_t i = 0; i < scanner_count && result == 0; i++) {
+        setenv("SYNTHEX_SCAN", scanners[i], 1);
+        scan_init();
+        if (strcmp(scan.name, scanners[i]) != 0) {
+            continue;
+        }
+        sessions[i] = compiler_session_create(filename, &options);
+        sessions[i]->lexer = lexer_create(filename);
+        if (sessions[i]->lexer == NULL) {
+            result = -1;
+            break;
+        }
+        sessions[i]->lexer->keep_comments = true;
+        lexer_lexall(sessions[i]->lexer, false);
+        if (i > 0 && !test_same_tokens(sessions[0]->lexer, sessions[i]->lexer)) {
+            fprintf(stderr, "%sERROR:%s Tokens differ with the %s scanner\n", ANSI_COLOR_RED, ANSI_COLOR_RESET, scanners[i]);
+            result = -1;
+        }
+    }
+    if (forced != NULL) {
+        setenv("SYNTHEX_SCAN", forced, 1);
+    } else {
+        unsetenv("SYNTHEX_SCAN");
+    }
+    free(forced);
+    scan_init();
+    for (size_t i = 0; i < scanner_count; i++) {
+        if (sessions[i] != NULL) {
+            compiler_session_destroy(sessions[i]);
+        }
+    }
+    return result;
 }
 
 int test_file(char *filename, char* expected_filename) {
-    Lexer *lexer = lexer_create(filename);
-    if (lexer == NULL) {
+    if (test_parse_jobs(filename) < 0 || test_errors(filename) < 0 || test_scanners(filename) < 0) {
+        return -1;
+    }
+    char *link_inputs[] = {"tests/t.c"};
+    CompilerOptions options = {.keep_comments = true, .emit = CODEGEN_OUTPUT_EXECUTABLE, .link_inputs = link_inputs,
+                               .link_input_count = 1};
+    if (test_program(filename, expected_filename, &options, false) < 0) {
+        return -1;
+    }
+    // Comments never change the program
+    options.keep_comments = false;
+    if (test_program(filename, expected_filename, &options, false) < 0) {
+        fprintf(stderr, "%sERROR:%s Build with --strip-comments differs\n", ANSI_COLOR_RED, ANSI_COLOR_RESET);
+        return -1;
+    }
+    options.keep_comments = true;
+    // Functions spread over modules that call into each other
+    options.codegen_jobs = 3;
+    if (test_program(filename, expected_filename, &options, false) < 0) {
+        fprintf(stderr, "%sERROR:%s Build with --codegen-jobs 3 differs\n", ANSI_COLOR_RED, ANSI_COLOR_RESET);
+        return -1;
+    }
+    options.codegen_jobs = 0;
+    // The run subcommand
+    char *libraries[] = {TEST_LIBRARY};
+    CompilerOptions run_options = {.keep_comments = true, .link_inputs = libraries, .link_input_count = 1};
+    if (test_program(filename, expected_filename, &run_options, true) < 0) {
+        fprintf(stderr, "%sERROR:%s Running in process differs\n", ANSI_COLOR_RED, ANSI_COLOR_RESET);
+        return -1;
+    }
+    // Once to fill the cache and once to build from it
+    options.cache_dir = TEST_CACHE_DIR;
+    if (test_program(filename, expected_filename, &options, false) < 0 || test_program(filename, expected_filename, &options, false) < 0) {
+        fprintf(stderr, "%sERROR:%s Incremental build differs\n", ANSI_COLOR_RED, ANSI_COLOR_RESET);
+        return -1;
+    }
+    return 0;
+}
+
+static int test_program(char *filename, char *expected_filename, const CompilerOptions *options, bool run) {
+    CompilerSession *session = compiler_session_create(filename, options);
+    if (!compiler_session_parse(session)) {
         fprintf(stderr, "%sERROR:%s Failed to create lexer\n", ANSI_COLOR_RED, ANSI_COLOR_RESET);
+        compiler_session_destroy(session);
         return -1;
     }
-    AST *ast = ast_create();
-    ast_build(ast, lexer);
-    ast_to_llvm(ast, lexer->filename, "test.ll", false);
-    ast_destroy(ast);
-    lexer_destroy(lexer);
-    
-    system("clang test.ll tests/t.c -o t");
+    if (!run) {
+        bool emitted = compiler_session_emit(session, "t", false);
+        compiler_session_destroy(session);
+        if (!emitted) {
+            fprintf(stderr, "%sERROR:%s Failed to build the test program\n", ANSI_COLOR_RED, ANSI_COLOR_RESET);
+            return -1;
+        }
+    }
 
     // Create a pipe to read the output of the program
     int pipefd[2];
@@ -78,7 +294,8 @@ int test_file(char *filename, char* expected_filename) {
         exit(1);
     }
 
-    // Fork a child process
+    // Fork a child process, with nothing buffered for it to print again
+    fflush(stdout);
     pid = fork();
     if (pid == -1) {
         perror("fork");
@@ -89,10 +306,18 @@ int test_file(char *filename, char* expected_filename) {
     if (pid == 0) {
         dup2(pipefd[1], STDOUT_FILENO);
         close(pipefd[0]);
+        if (run) {
+            int exit_code = 1;
+            compiler_session_run(session, &exit_code);
+            exit(exit_code);
+        }
         execl("./t", "t", NULL); // Replace with actual arguments
         perror("execl");
         exit(1);
     }
+    if (run) {
+        compiler_session_destroy(session);
+    }
 
     // Parent process: read from pipe (stdout of child)
     close(pipefd[1]); // Close write end
@@ -106,10 +331,10 @@ int test_file(char *filename, char* expected_filename) {
         bytes_read += bytes;
     }
 
-    // Wait for child process to finish
-    wait(NULL);
-    // Get the exit code of the program
-    int exit_code = WEXITSTATUS(system("./t >> /dev/null 2>&1"));
+    // Wait for child process to finish and get the exit code of the program
+    int status = 0;
+    waitpid(pid, &status, 0);
+    int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
     if (exit_code != 0) {
         fprintf(stderr, "%sERROR:%sProgram exited with non-zero exit code: %d\n", ANSI_COLOR_RED, ANSI_COLOR_RESET, exit_code);
         return -1;
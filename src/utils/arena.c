@@ -0,0 +1,63 @@
+#include "utils/arena.h"
+
+#include <stdalign.h>
+#include <stdlib.h>
+
+#define ARENA_ALIGNMENT alignof(max_align_t)
+
+struct ArenaChunk {
+    ArenaChunk* next;
+    size_t used;
+    size_t capacity;
+    alignas(ARENA_ALIGNMENT) char data[];
+};
+
+Arena* arena_create(size_t chunk_size) {
+    Arena* arena = malloc(sizeof(Arena));
+    arena->chunks = NULL;
+    arena->chunk_size = chunk_size;
+    return arena;
+}
+
+void arena_destroy(Arena* arena) {
+    ArenaChunk* chunk = arena->chunks;
+    while (chunk != NULL) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    ArenaChunk* chunk = arena->chunks;
+    if (chunk == NULL || chunk->capacity - chunk->used < size) {
+        size_t capacity = size > arena->chunk_size ? size : arena->chunk_size;
+        // Fresh chunks come zeroed, so allocations need no clearing of their own
+        chunk = calloc(1, sizeof(ArenaChunk) + capacity);
+        chunk->next = arena->chunks;
+        chunk->capacity = capacity;
+        arena->chunks = chunk;
+    }
+    void* memory = chunk->data + chunk->used;
+    chunk->used += size;
+    return memory;
+}
+
+void arena_merge(Arena* into, Arena* from) {
+    ArenaChunk* tail = from->chunks;
+    if (tail != NULL) {
+        while (tail->next != NULL) {
+            tail = tail->next;
+        }
+        // Behind the head, so into keeps bumping through its current chunk
+        if (into->chunks == NULL) {
+            into->chunks = from->chunks;
+        } else {
+            tail->next = into->chunks->next;
+            into->chunks->next = from->chunks;
+        }
+    }
+    free(from);
+}
@@ -1,21 +1,95 @@
 #include "utils/ast_data.h"
+#include "utils/interner.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+#define AST_DATA_INDEX_INITIAL_SLOTS 64
+
+static size_t ast_data_index_home(ASTDataIndex* index, uint32_t name_id) {
+    // Interned ids are dense, spread them over the table
+    return (name_id * 2654435761u) & (index->slot_count - 1);
+}
+
+static void ast_data_index_insert(ASTDataIndex* index, uint32_t name_id, size_t position);
+
+// Doubles the slots once half are used. Entries go back in position order so
+// that the earliest of several with one name still comes first when probing.
+static void ast_data_index_grow(ASTDataIndex* index) {
+    ASTDataIndexSlot* slots = index->slots;
+    size_t slot_count = index->slot_count;
+    uint32_t* name_ids = malloc(sizeof(uint32_t) * (index->count + 1));
+    for (size_t i = 0; i < slot_count; i++) {
+        if (slots[i].position != 0) {
+            name_ids[slots[i].position - 1] = slots[i].name_id;
+        }
+    }
+    size_t count = index->count;
+    index->slot_count = slot_count == 0 ? AST_DATA_INDEX_INITIAL_SLOTS : slot_count * 2;
+    index->slots = calloc(index->slot_count, sizeof(ASTDataIndexSlot));
+    index->count = 0;
+    for (size_t i = 0; i < count; i++) {
+        ast_data_index_insert(index, name_ids[i], i);
+    }
+    free(name_ids);
+    free(slots);
+}
+
+static void ast_data_index_insert(ASTDataIndex* index, uint32_t name_id, size_t position) {
+    if ((index->count + 1) * 2 > index->slot_count) {
+        ast_data_index_grow(index);
+    }
+    size_t slot = ast_data_index_home(index, name_id);
+    while (index->slots[slot].position != 0) {
+        slot = (slot + 1) & (index->slot_count - 1);
+    }
+    index->slots[slot] = (ASTDataIndexSlot){name_id, position + 1};
+    index->count++;
+}
+
+// Only valid for the entry added last. Nothing was placed behind it since, so
+// freeing its slot leaves every other probe chain as it was.
+static void ast_data_index_remove(ASTDataIndex* index, uint32_t name_id, size_t position) {
+    size_t slot = ast_data_index_home(index, name_id);
+    while (index->slots[slot].position != position + 1) {
+        slot = (slot + 1) & (index->slot_count - 1);
+    }
+    index->slots[slot].position = 0;
+    index->count--;
+}
+
+// Position of the earliest entry named name_id, if it is below count
+static bool ast_data_index_find(ASTDataIndex* index, uint32_t name_id, size_t count, size_t* position) {
+    if (index->count == 0 || name_id == INTERNER_NONE) {
+        return false;
+    }
+    size_t slot = ast_data_index_home(index, name_id);
+    while (index->slots[slot].position != 0) {
+        if (index->slots[slot].name_id == name_id) {
+            *position = index->slots[slot].position - 1;
+            return *position < count;
+        }
+        slot = (slot + 1) & (index->slot_count - 1);
+    }
+    return false;
+}
+
+static void ast_data_index_destroy(ASTDataIndex* index) {
+    free(index->slots);
+}
+
+// Grows a table of pointers geometrically, returning it with room for one more
+static void* ast_data_table_reserve(void* table, size_t count, size_t* capacity) {
+    if (count < *capacity) {
+        return table;
+    }
+    *capacity = *capacity == 0 ? 16 : *capacity * 2;
+    return realloc(table, sizeof(void*) * *capacity);
+}
 
 ASTData* ast_data_create() {
-    ASTData* ast_data = malloc(sizeof(ASTData));
-    ast_data->functions = NULL;
-    ast_data->function_count = 0;
-    ast_data->variables = NULL;
-    ast_data->variable_count = 0;
-    ast_data->pointers = NULL;
-    ast_data->pointer_count = 0;
-    ast_data->arrays = NULL;
-    ast_data->array_count = 0;
-    ast_data->structs = NULL;
-    ast_data->struct_count = 0;
-    
-    ast_data_add_builtin_types(ast_data);
+    ASTData* ast_data = calloc(1, sizeof(ASTData));
+    ast_data->types = type_registry;
     return ast_data;
 }
 
@@ -40,106 +114,163 @@ void ast_data_destroy(ASTData* ast_data) {
     free(ast_data->pointers);
     free(ast_data->arrays);
     free(ast_data->structs);
-    free(ast_data->data_types);
+    ast_data_index_destroy(&ast_data->function_index);
+    ast_data_index_destroy(&ast_data->variable_index);
+    ast_data_index_destroy(&ast_data->pointer_index);
+    ast_data_index_destroy(&ast_data->array_index);
+    ast_data_index_destroy(&ast_data->struct_index);
     free(ast_data);
 }
 
-void ast_data_add_builtin_types(ASTData* ast_data) {
-    ast_data->data_type_count = DATA_TYPE_TOTAL;
-    ast_data->data_types = malloc(sizeof(DataType) * ast_data->data_type_count);
-    ast_data->data_types[0] = (DataType) {
-        .id = DATA_TYPE_I8,
-        .name = "i8",
-        .builtin = true,
-    };
-    ast_data->data_types[1] = (DataType) {
-        .id = DATA_TYPE_I16,
-        .name = "i16",
-        .builtin = true,
-    };
-    ast_data->data_types[2] = (DataType) {
-        .id = DATA_TYPE_I32,
-        .name = "i32",
-        .builtin = true,
-    };
-    ast_data->data_types[3] = (DataType) {
-        .id = DATA_TYPE_I64,
-        .name = "i64",
-        .builtin = true,
-    };
-    ast_data->data_types[4] = (DataType) {
-        .id = DATA_TYPE_F32,
-        .name = "f32",
-        .builtin = true,
-    };
-    ast_data->data_types[5] = (DataType) {
-        .id = DATA_TYPE_F64,
-        .name = "f64",
-        .builtin = true,
-    };
-    ast_data->data_types[6] = (DataType) {
-        .id = DATA_TYPE_STR,
-        .name = "str",
-        .builtin = true,
-    };
-    ast_data->data_types[7] = (DataType) {
-        .id = DATA_TYPE_CHR,
-        .name = "chr",
-        .builtin = true,
-    };
-    ast_data->data_types[8] = (DataType) {
-        .id = DATA_TYPE_BLN,
-        .name = "bln",
-        .builtin = true,
-    };
-    ast_data->data_types[9] = (DataType) {
-        .id = DATA_TYPE_VOID,
-        .name = "void",
-        .builtin = true,
-    };
-    ast_data->data_types[10] = (DataType) {
-        .id = DATA_TYPE_PTR,
-        .name = "ptr",
-        .builtin = true,
-    };
-}
-
 void ast_data_add_function(ASTData* ast_data, Function* function) {
-    ast_data->functions = realloc(ast_data->functions, sizeof(Function*) * (ast_data->function_count + 1));
-    ast_data->functions[ast_data->function_count] = function;
-    ast_data->function_count++;
+    ast_data->functions = ast_data_table_reserve(ast_data->functions, ast_data->function_count, &ast_data->function_capacity);
+    ast_data_index_insert(&ast_data->function_index, function->name_id, ast_data->function_count);
+    ast_data->functions[ast_data->function_count++] = function;
 }
 
 void ast_data_add_variable(ASTData* ast_data, Variable* variable) {
-    ast_data->variables = realloc(ast_data->variables, sizeof(Variable*) * (ast_data->variable_count + 1));
-    ast_data->variables[ast_data->variable_count] = variable;
-    ast_data->variable_count++;
+    ast_data->variables = ast_data_table_reserve(ast_data->variables, ast_data->variable_count, &ast_data->variable_capacity);
+    ast_data_index_insert(&ast_data->variable_index, variable->name_id, ast_data->variable_count);
+    ast_data->variables[ast_data->variable_count++] = variable;
 }
 void ast_data_add_pointer(ASTData* ast_data, Pointer* pointer) {
-    ast_data->pointers = realloc(ast_data->pointers, sizeof(Pointer*) * (ast_data->pointer_count + 1));
-    ast_data->pointers[ast_data->pointer_count] = pointer;
-    ast_data->pointer_count++;
+    ast_data->pointers = ast_data_table_reserve(ast_data->pointers, ast_data->pointer_count, &ast_data->pointer_capacity);
+    ast_data_index_insert(&ast_data->pointer_index, pointer->name_id, ast_data->pointer_count);
+    ast_data->pointers[ast_data->pointer_count++] = pointer;
 }
 void ast_data_add_array(ASTData* ast_data, Array* array) {
-    ast_data->arrays = realloc(ast_data->arrays, sizeof(Array*) * (ast_data->array_count + 1));
-    ast_data->arrays[ast_data->array_count] = array;
-    ast_data->array_count++;
+    ast_data->arrays = ast_data_table_reserve(ast_data->arrays, ast_data->array_count, &ast_data->array_capacity);
+    ast_data_index_insert(&ast_data->array_index, array->name_id, ast_data->array_count);
+    ast_data->arrays[ast_data->array_count++] = array;
 }
 
 void ast_data_add_struct(ASTData* ast_data, Struct* strct) {
-    ast_data->structs = realloc(ast_data->structs, sizeof(Struct*) * (ast_data->struct_count + 1));
-    ast_data->structs[ast_data->struct_count] = strct;
-    ast_data->struct_count++;
-
-    ast_data->data_type_count++;
-    ast_data->data_types = realloc(ast_data->data_types, sizeof(DataType) * ast_data->data_type_count);
-    ast_data->data_types[ast_data->data_type_count - 1] = (DataType) {
-        .id = ast_data->data_type_count - 1,
-        .name = strct->name,
-        .builtin = false,
+    ast_data->structs = ast_data_table_reserve(ast_data->structs, ast_data->struct_count, &ast_data->struct_capacity);
+    ast_data_index_insert(&ast_data->struct_index, strct->name_id, ast_data->struct_count);
+    ast_data->structs[ast_data->struct_count++] = strct;
+    // Normally the lexer registered it already
+    type_registry_add(ast_data->types, strct->name_id);
+}
+
+DataType* ast_data_find_data_type(ASTData* ast_data, uint32_t name_id) {
+    return type_registry_find(ast_data->types, name_id);
+}
+
+Function* ast_data_find_function(ASTData* ast_data, uint32_t name_id) {
+    size_t position;
+    if (!ast_data_index_find(&ast_data->function_index, name_id, ast_data->function_count, &position)) {
+        return NULL;
+    }
+    return ast_data->functions[position];
+}
+
+Variable* ast_data_find_variable(ASTData* ast_data, uint32_t name_id) {
+    size_t position;
+    if (!ast_data_index_find(&ast_data->variable_index, name_id, ast_data->variable_count, &position)) {
+        return NULL;
+    }
+    return ast_data->variables[position];
+}
+
+Pointer* ast_data_find_pointer(ASTData* ast_data, uint32_t name_id) {
+    size_t position;
+    if (!ast_data_index_find(&ast_data->pointer_index, name_id, ast_data->pointer_count, &position)) {
+        return NULL;
+    }
+    return ast_data->pointers[position];
+}
+
+Array* ast_data_find_array(ASTData* ast_data, uint32_t name_id) {
+    size_t position;
+    if (!ast_data_index_find(&ast_data->array_index, name_id, ast_data->array_count, &position)) {
+        return NULL;
+    }
+    return ast_data->arrays[position];
+}
+
+Struct* ast_data_find_struct(ASTData* ast_data, uint32_t name_id) {
+    size_t position;
+    if (!ast_data_index_find(&ast_data->struct_index, name_id, ast_data->struct_count, &position)) {
+        return NULL;
+    }
+    return ast_data->structs[position];
+}
+
+ASTDataScope ast_data_open_scope(ASTData* ast_data) {
+    return (ASTDataScope){
+        .function_count = ast_data->function_count,
+        .struct_count = ast_data->struct_count,
+        .variable_count = ast_data->variable_count,
+        .pointer_count = ast_data->pointer_count,
+        .array_count = ast_data->array_count,
     };
 }
 
+void ast_data_close_scope(ASTData* ast_data, ASTDataScope scope) {
+    while (ast_data->variable_count > scope.variable_count) {
+        Variable* variable = ast_data->variables[--ast_data->variable_count];
+        ast_data_index_remove(&ast_data->variable_index, variable->name_id, ast_data->variable_count);
+        ast_data_variable_destroy(variable);
+    }
+    while (ast_data->pointer_count > scope.pointer_count) {
+        Pointer* pointer = ast_data->pointers[--ast_data->pointer_count];
+        ast_data_index_remove(&ast_data->pointer_index, pointer->name_id, ast_data->pointer_count);
+        ast_data_pointer_destroy(pointer);
+    }
+    while (ast_data->array_count > scope.array_count) {
+        Array* array = ast_data->arrays[--ast_data->array_count];
+        ast_data_index_remove(&ast_data->array_index, array->name_id, ast_data->array_count);
+        ast_data_array_destroy(array);
+    }
+}
+
+static void* ast_data_copy_table(void* table, size_t count) {
+    if (count == 0) {
+        return NULL;
+    }
+    void* copy = malloc(sizeof(void*) * count);
+    memcpy(copy, table, sizeof(void*) * count);
+    return copy;
+}
+
+ASTData* ast_data_view_create(ASTData* ast_data, ASTDataScope scope) {
+    ASTData* view = malloc(sizeof(ASTData));
+    *view = *ast_data;
+    view->function_count = scope.function_count;
+    view->struct_count = scope.struct_count;
+
+    view->variables = ast_data_copy_table(ast_data->variables, scope.variable_count);
+    view->variable_count = view->variable_capacity = scope.variable_count;
+    view->variable_index = (ASTDataIndex){0};
+    for (size_t i = 0; i < view->variable_count; i++) {
+        ast_data_index_insert(&view->variable_index, view->variables[i]->name_id, i);
+    }
+    view->pointers = ast_data_copy_table(ast_data->pointers, scope.pointer_count);
+    view->pointer_count = view->pointer_capacity = scope.pointer_count;
+    view->pointer_index = (ASTDataIndex){0};
+    for (size_t i = 0; i < view->pointer_count; i++) {
+        ast_data_index_insert(&view->pointer_index, view->pointers[i]->name_id, i);
+    }
+    view->arrays = ast_data_copy_table(ast_data->arrays, scope.array_count);
+    view->array_count = view->array_capacity = scope.array_count;
+    view->array_index = (ASTDataIndex){0};
+    for (size_t i = 0; i < view->array_count; i++) {
+        ast_data_index_insert(&view->array_index, view->arrays[i]->name_id, i);
+    }
+    return view;
+}
+
+void ast_data_view_destroy(ASTData* view, ASTDataScope scope) {
+    ast_data_close_scope(view, scope);
+    free(view->variables);
+    free(view->pointers);
+    free(view->arrays);
+    ast_data_index_destroy(&view->variable_index);
+    ast_data_index_destroy(&view->pointer_index);
+    ast_data_index_destroy(&view->array_index);
+    free(view);
+}
+
 void ast_data_print(ASTData* ast_data) {
     printf("Functions:\n");
     for (size_t i = 0; i < ast_data->function_count; i++) {
@@ -166,6 +297,7 @@ void ast_data_print(ASTData* ast_data) {
 Function* ast_data_function_create(const char* name, DataType* return_type, const char** arguments, DataType** argument_types, size_t argument_count) {
     Function* function = malloc(sizeof(Function));
     function->name = name;
+    function->name_id = interner_find(interner, name);
     function->return_type = return_type;
     function->arguments = arguments;
     function->argument_types = argument_types;
@@ -173,12 +305,15 @@ Function* ast_data_function_create(const char* name, DataType* return_type, cons
     return function;
 }
 void ast_data_function_destroy(Function* function) {
+    free(function->arguments);
+    free(function->argument_types);
     free(function);
 }
 
 Variable* ast_data_variable_create(const char* name, DataType* type) {
     Variable* variable = malloc(sizeof(Variable));
     variable->name = name;
+    variable->name_id = interner_find(interner, name);
     variable->type = type;
     return variable;
 }
@@ -189,6 +324,7 @@ void ast_data_variable_destroy(Variable* variable) {
 Pointer* ast_data_pointer_create(const char* name, DataType* base_type, size_t degree) {
     Pointer* pointer = malloc(sizeof(Pointer));
     pointer->name = name;
+    pointer->name_id = interner_find(interner, name);
     pointer->base_type = base_type;
     pointer->degree = degree;
     return pointer;
@@ -200,6 +336,7 @@ void ast_data_pointer_destroy(Pointer* pointer) {
 Array* ast_data_array_create(const char* name, DataType* base_type, size_t dimension) {
     Array* array = malloc(sizeof(Array));
     array->name = name;
+    array->name_id = interner_find(interner, name);
     array->base_type = base_type;
     array->dimension = dimension;
     return array;
@@ -211,6 +348,7 @@ void ast_data_array_destroy(Array* array) {
 Struct* ast_data_struct_create(const char* name) {
     Struct* strct = malloc(sizeof(Struct));
     strct->name = name;
+    strct->name_id = interner_find(interner, name);
     strct->members = NULL;
     strct->member_count = 0;
     return strct;
@@ -227,9 +365,7 @@ void ast_data_struct_add_member(Struct* strct, Variable* member) {
 }
 
 void ast_data_struct_destroy(Struct* strct) {
-    for (size_t i = 0; i < strct->member_count; i++) {
-        ast_data_variable_destroy(&strct->members[i]);
-    }
+    // Members are stored by value
     free(strct->members);
     free(strct);
 }
@@ -0,0 +1,319 @@
+#include "utils/build_cache.h"
+
+#include "codegen.h"
+#include "version.h"
+
+#include <llvm/Config/llvm-config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Part of every key along with the target, so that objects of another
+// compiler or LLVM are never reused
+#define BUILD_CACHE_VERSION SYNTHEX_VERSION " " LLVM_VERSION_STRING
+
+#define BUILD_CACHE_SEED 14695981039346656037u
+
+// FNV-1a, 64 bit
+static uint64_t build_cache_hash(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211u;
+    }
+    return hash;
+}
+
+// Hashes what the token means rather than where it is, so that moving code
+// around or editing comments keeps the keys
+static uint64_t build_cache_hash_token(uint64_t hash, Lexer* lexer, Token* token) {
+    hash = build_cache_hash(hash, &token->type, sizeof(token->type));
+    if (token->type == TOKEN_OPERATOR) {
+        return build_cache_hash(hash, &token->op, sizeof(token->op));
+    } else if (token->type == TOKEN_PUNCTUATION) {
+        return build_cache_hash(hash, &token->punctuation, sizeof(token->punctuation));
+    }
+    hash = build_cache_hash(hash, &token->length, sizeof(token->length));
+    return build_cache_hash(hash, lexer->contents + token->offset, token->length);
+}
+
+static bool build_cache_is(Token* token, PunctuationType punctuation) {
+    return token->type == TOKEN_PUNCTUATION && token->punctuation == punctuation;
+}
+
+static bool build_cache_is_comment(Token* token) {
+    return token->type == TOKEN_COMMENT || token->type == TOKEN_DOC_COMMENT;
+}
+
+// Finds the brace closing the body opened at start. Sets cacheable to false
+// if the body declares functions or structs.
+static size_t build_cache_body_end(Token* tokens, size_t start, bool* cacheable) {
+    size_t depth = 0;
+    size_t end = start;
+    *cacheable = true;
+    for (; tokens[end].type != TOKEN_EOF; end++) {
+        if (build_cache_is(&tokens[end], PUNCTUATION_LBRACE)) {
+            depth++;
+        } else if (build_cache_is(&tokens[end], PUNCTUATION_RBRACE) && --depth == 0) {
+            break;
+        } else if (tokens[end].type == TOKEN_KEYWORD &&
+                   (tokens[end].keyword == KEYWORD_FNC || tokens[end].keyword == KEYWORD_STRUCT)) {
+            *cacheable = false;
+        }
+    }
+    return end;
+}
+
+// Entries sorted by key, to find the members of the groups in the manifest
+typedef struct BuildCacheSlot {
+    uint64_t key;
+    size_t entry;
+} BuildCacheSlot;
+
+static int build_cache_compare_slots(const void* a, const void* b) {
+    uint64_t x = ((const BuildCacheSlot*)a)->key;
+    uint64_t y = ((const BuildCacheSlot*)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+static BuildCacheSlot* build_cache_find(BuildCacheSlot* slots, size_t count, uint64_t key) {
+    BuildCacheSlot wanted = {key, 0};
+    return bsearch(&wanted, slots, count, sizeof(BuildCacheSlot), build_cache_compare_slots);
+}
+
+static char* build_cache_path(const char* directory, uint64_t key, const char* extension) {
+    size_t length = strlen(directory) + strlen(extension) + 18;
+    char* path = malloc(length);
+    snprintf(path, length, "%s/%016llx%s", directory, (unsigned long long)key, extension);
+    return path;
+}
+
+static char* build_cache_object(BuildCache* cache, uint64_t key) {
+    return build_cache_path(cache->directory, key, codegen_output_extension(CODEGEN_OUTPUT_OBJECT));
+}
+
+static void build_cache_push_group(BuildCache* cache, BuildCacheGroup group) {
+    if (cache->group_count == cache->group_capacity) {
+        cache->group_capacity = cache->group_capacity == 0 ? 16 : cache->group_capacity * 2;
+        cache->groups = realloc(cache->groups, cache->group_capacity * sizeof(BuildCacheGroup));
+    }
+    cache->groups[cache->group_count++] = group;
+}
+
+// Keeps the groups of the manifest whose object exists and whose bodies are
+// all still there, and marks those bodies cached
+static void build_cache_load(BuildCache* cache) {
+    FILE* manifest = fopen(cache->manifest, "r");
+    if (manifest == NULL) {
+        return;
+    }
+    BuildCacheSlot* slots = malloc((cache->entry_count + 1) * sizeof(BuildCacheSlot));
+    size_t slot_count = 0;
+    for (size_t i = 0; i < cache->entry_count; i++) {
+        if (cache->entries[i].cacheable) {
+            slots[slot_count++] = (BuildCacheSlot){cache->entries[i].key, i};
+        }
+    }
+    qsort(slots, slot_count, sizeof(BuildCacheSlot), build_cache_compare_slots);
+
+    unsigned long long key;
+    size_t count;
+    size_t previous_capacity = 0;
+    while (fscanf(manifest, "%llx %zu", &key, &count) == 2 && count <= cache->entry_count) {
+        if (cache->previous_count == previous_capacity) {
+            previous_capacity = previous_capacity == 0 ? 16 : previous_capacity * 2;
+            cache->previous = realloc(cache->previous, previous_capacity * sizeof(uint64_t));
+        }
+        cache->previous[cache->previous_count++] = key;
+        uint64_t* members = malloc((count + 1) * sizeof(uint64_t));
+        bool read = true;
+        bool valid = true;
+        for (size_t i = 0; i < count && read; i++) {
+            unsigned long long member;
+            read = fscanf(manifest, "%llx", &member) == 1;
+            members[i] = member;
+            BuildCacheSlot* slot = read ? build_cache_find(slots, slot_count, member) : NULL;
+            valid = valid && slot != NULL && !cache->entries[slot->entry].cached;
+        }
+        valid = valid && read;
+        char* object = build_cache_object(cache, key);
+        FILE* file = valid ? fopen(object, "rb") : NULL;
+        if (file == NULL) {
+            free(object);
+            free(members);
+            continue;
+        }
+        fclose(file);
+        build_cache_push_group(cache, (BuildCacheGroup){key, object, members, count});
+        for (size_t i = 0; i < count; i++) {
+            cache->entries[build_cache_find(slots, slot_count, members[i])->entry].cached = true;
+        }
+    }
+    free(slots);
+    fclose(manifest);
+}
+
+BuildCache* build_cache_create(Lexer* lexer, const char* directory, const char* source, const char* salt) {
+#ifdef _WIN32
+    _mkdir(directory);
+#else
+    mkdir(directory, 0755);
+#endif
+    BuildCache* cache = calloc(1, sizeof(BuildCache));
+    cache->directory = strdup(directory);
+    cache->source = build_cache_hash(BUILD_CACHE_SEED, source, strlen(source));
+    cache->manifest = build_cache_path(directory, cache->source, ".manifest");
+    size_t capacity = 0;
+    size_t* keyed_starts = NULL;  // The fnc keyword, so the name is part of the key
+    size_t* keyed_ends = NULL;    // Closing brace, 0 for bodies that are not cached
+    Token* tokens = lexer->tokens;
+
+    // Everything outside the cacheable bodies goes into one context hash
+    char* target = codegen_target_description();
+    uint64_t context = build_cache_hash(BUILD_CACHE_SEED, BUILD_CACHE_VERSION, strlen(BUILD_CACHE_VERSION) + 1);
+    context = build_cache_hash(context, target, strlen(target) + 1);
+    context = build_cache_hash(context, salt, strlen(salt) + 1);
+    free(target);
+    size_t depth = 0;
+    for (size_t i = 0; tokens[i].type != TOKEN_EOF; i++) {
+        Token* token = &tokens[i];
+        if (build_cache_is_comment(token)) {
+            continue;
+        }
+        context = build_cache_hash_token(context, lexer, token);
+        if (build_cache_is(token, PUNCTUATION_LBRACE)) {
+            depth++;
+        } else if (build_cache_is(token, PUNCTUATION_RBRACE) && depth > 0) {
+            depth--;
+        }
+        if (depth != 0 || token->type != TOKEN_KEYWORD || token->keyword != KEYWORD_FNC) {
+            continue;
+        }
+
+        size_t start = i + 1;
+        while (tokens[start].type != TOKEN_EOF && !build_cache_is(&tokens[start], PUNCTUATION_LBRACE) &&
+               !build_cache_is(&tokens[start], PUNCTUATION_SEMICOLON)) {
+            start++;
+        }
+        if (!build_cache_is(&tokens[start], PUNCTUATION_LBRACE)) {
+            continue;
+        }
+        bool cacheable;
+        size_t end = build_cache_body_end(tokens, start, &cacheable);
+        if (tokens[end].type == TOKEN_EOF) {
+            break;  // Left for the parser to report
+        }
+        if (cache->entry_count == capacity) {
+            capacity = capacity == 0 ? 64 : capacity * 2;
+            cache->entries = realloc(cache->entries, capacity * sizeof(BuildCacheEntry));
+            keyed_starts = realloc(keyed_starts, capacity * sizeof(size_t));
+            keyed_ends = realloc(keyed_ends, capacity * sizeof(size_t));
+        }
+        cache->entries[cache->entry_count] = (BuildCacheEntry){start, 0, cacheable, false};
+        keyed_starts[cache->entry_count] = i;
+        keyed_ends[cache->entry_count++] = cacheable ? end : 0;
+        if (cacheable) {
+            // The signature is part of the context, the body is not
+            for (i++; i < start; i++) {
+                if (!build_cache_is_comment(&tokens[i])) {
+                    context = build_cache_hash_token(context, lexer, &tokens[i]);
+                }
+            }
+            i = end;
+        }
+    }
+
+    for (size_t i = 0; i < cache->entry_count; i++) {
+        BuildCacheEntry* entry = &cache->entries[i];
+        if (!entry->cacheable) {
+            continue;
+        }
+        entry->key = context;
+        for (size_t j = keyed_starts[i]; j <= keyed_ends[i]; j++) {
+            if (!build_cache_is_comment(&tokens[j])) {
+                entry->key = build_cache_hash_token(entry->key, lexer, &tokens[j]);
+            }
+        }
+    }
+    free(keyed_starts);
+    free(keyed_ends);
+    build_cache_load(cache);
+    return cache;
+}
+
+const char* build_cache_add_group(BuildCache* cache, const size_t* entries, size_t count) {
+    uint64_t* members = malloc((count + 1) * sizeof(uint64_t));
+    uint64_t key = cache->source;
+    for (size_t i = 0; i < count; i++) {
+        members[i] = cache->entries[entries[i]].key;
+        key = build_cache_hash(key, &members[i], sizeof(uint64_t));
+    }
+    build_cache_push_group(cache, (BuildCacheGroup){key, build_cache_object(cache, key), members, count});
+    return cache->groups[cache->group_count - 1].object;
+}
+
+bool build_cache_commit(BuildCache* cache) {
+    size_t length = strlen(cache->manifest) + 5;
+    char* temporary = malloc(length);
+    snprintf(temporary, length, "%s.tmp", cache->manifest);
+    FILE* manifest = fopen(temporary, "w");
+    bool written = manifest != NULL;
+    for (size_t i = 0; written && i < cache->group_count; i++) {
+        BuildCacheGroup* group = &cache->groups[i];
+        fprintf(manifest, "%016llx %zu", (unsigned long long)group->key, group->member_count);
+        for (size_t j = 0; j < group->member_count; j++) {
+            fprintf(manifest, " %016llx", (unsigned long long)group->members[j]);
+        }
+        fprintf(manifest, "\n");
+    }
+    if (manifest != NULL) {
+        written = fclose(manifest) == 0 && written;
+    }
+    // Replaced in one step, so a failed build never leaves half a manifest
+#ifdef _WIN32
+    if (written) {
+        remove(cache->manifest);
+    }
+#endif
+    written = written && rename(temporary, cache->manifest) == 0;
+    if (!written) {
+        fprintf(stderr, "Error: Could not write %s\n", cache->manifest);
+        remove(temporary);
+        free(temporary);
+        return false;
+    }
+    free(temporary);
+
+    // Groups are never shared between files, so the objects of the groups
+    // this file no longer lists can go
+    for (size_t i = 0; i < cache->previous_count; i++) {
+        bool used = false;
+        for (size_t j = 0; j < cache->group_count && !used; j++) {
+            used = cache->groups[j].key == cache->previous[i];
+        }
+        if (!used) {
+            char* object = build_cache_object(cache, cache->previous[i]);
+            remove(object);
+            free(object);
+        }
+    }
+    return true;
+}
+
+void build_cache_destroy(BuildCache* cache) {
+    for (size_t i = 0; i < cache->group_count; i++) {
+        free(cache->groups[i].object);
+        free(cache->groups[i].members);
+    }
+    free(cache->groups);
+    free(cache->previous);
+    free(cache->entries);
+    free(cache->directory);
+    free(cache->manifest);
+    free(cache);
+}
@@ -1,50 +1,121 @@
 #include "utils/codegen_data.h"
+#include "utils/interner.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-CodegenData* codegen_data_create(LLVMModuleRef module, LLVMContextRef context) {
-    CodegenData* data = malloc(sizeof(CodegenData));
-    data->functions = NULL;
-    data->variables = NULL;
-    data->arrays = NULL;
-    data->pointers = NULL;
-    data->structs = NULL;
-    data->while_merge_block = NULL;
-    data->while_cond_block = NULL;
-    data->current_function = NULL;
-
-    data->function_count = 0;
-    data->variable_count = 0;
-    data->array_count = 0;
-    data->pointer_count = 0;
-    data->struct_count = 0;
+#define CODEGEN_DATA_INITIAL_SLOTS 64
+
+static size_t codegen_data_symbol_home(CodegenData_SymbolTable* table, uint32_t name_id) {
+    return (name_id * 2654435761u) & (table->slot_count - 1);
+}
+
+static CodegenData_SymbolSlot* codegen_data_symbol_find(CodegenData_SymbolTable* table, uint32_t name_id) {
+    if (table->slot_count == 0) {
+        return NULL;
+    }
+    size_t slot = codegen_data_symbol_home(table, name_id);
+    while (table->slots[slot].name_id != INTERNER_NONE) {
+        if (table->slots[slot].name_id == name_id) {
+            return &table->slots[slot];
+        }
+        slot = (slot + 1) & (table->slot_count - 1);
+    }
+    return NULL;
+}
+
+// Doubles the slots once half are used, dropping names nothing is bound to
+static void codegen_data_symbol_grow(CodegenData_SymbolTable* table) {
+    CodegenData_SymbolSlot* slots = table->slots;
+    size_t slot_count = table->slot_count;
+    table->slot_count = slot_count == 0 ? CODEGEN_DATA_INITIAL_SLOTS : slot_count * 2;
+    table->slots = calloc(table->slot_count, sizeof(CodegenData_SymbolSlot));
+    table->name_count = 0;
+    for (size_t i = 0; i < slot_count; i++) {
+        if (slots[i].name_id == INTERNER_NONE || slots[i].value == NULL) {
+            continue;
+        }
+        size_t slot = codegen_data_symbol_home(table, slots[i].name_id);
+        while (table->slots[slot].name_id != INTERNER_NONE) {
+            slot = (slot + 1) & (table->slot_count - 1);
+        }
+        table->slots[slot] = slots[i];
+        table->name_count++;
+    }
+    free(slots);
+}
+
+static CodegenData_SymbolSlot* codegen_data_symbol_insert(CodegenData_SymbolTable* table, uint32_t name_id) {
+    CodegenData_SymbolSlot* found = codegen_data_symbol_find(table, name_id);
+    if (found != NULL) {
+        return found;
+    }
+    if ((table->name_count + 1) * 2 > table->slot_count) {
+        codegen_data_symbol_grow(table);
+    }
+    size_t slot = codegen_data_symbol_home(table, name_id);
+    while (table->slots[slot].name_id != INTERNER_NONE) {
+        slot = (slot + 1) & (table->slot_count - 1);
+    }
+    table->slots[slot] = (CodegenData_SymbolSlot){name_id, NULL};
+    table->name_count++;
+    return &table->slots[slot];
+}
 
+static void codegen_data_bind(CodegenData* data, CodegenData_SymbolKind kind, uint32_t name_id, void* value) {
+    CodegenData_SymbolSlot* slot = codegen_data_symbol_insert(&data->symbols[kind], name_id);
+    if (data->binding_count == data->binding_capacity) {
+        data->binding_capacity = data->binding_capacity == 0 ? 64 : data->binding_capacity * 2;
+        data->bindings = realloc(data->bindings, sizeof(CodegenData_Binding) * data->binding_capacity);
+    }
+    data->bindings[data->binding_count++] = (CodegenData_Binding){kind, name_id, value, slot->value};
+    slot->value = value;
+}
+
+// Undoes bindings until only the first count are left
+static void codegen_data_unbind(CodegenData* data, size_t count) {
+    while (data->binding_count > count) {
+        CodegenData_Binding* binding = &data->bindings[--data->binding_count];
+        codegen_data_symbol_find(&data->symbols[binding->kind], binding->name_id)->value = binding->shadowed;
+        switch (binding->kind) {
+            case CODEGEN_SYMBOL_VARIABLE:
+                codegen_data_variable_destroy(binding->value);
+                break;
+            case CODEGEN_SYMBOL_ARRAY:
+                codegen_data_array_destroy(binding->value);
+                break;
+            case CODEGEN_SYMBOL_POINTER:
+                codegen_data_pointer_destroy(binding->value);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+CodegenData* codegen_data_create(LLVMModuleRef module, LLVMContextRef context) {
+    CodegenData* data = calloc(1, sizeof(CodegenData));
     data->module = module;
     data->context = context;
+    data->partition_count = 1;
     return data;
 }
 
 void codegen_data_destroy(CodegenData* data) {
+    codegen_data_unbind(data, 0);
     for (size_t i = 0; i < data->function_count; i++) {
         codegen_data_function_destroy(data->functions[i]);
     }
-    for (size_t i = 0; i < data->variable_count; i++) {
-        codegen_data_variable_destroy(data->variables[i]);
-    }
-    for (size_t i = 0; i < data->array_count; i++) {
-        codegen_data_array_destroy(data->arrays[i]);
-    }
-    for (size_t i = 0; i < data->pointer_count; i++) {
-        codegen_data_pointer_destroy(data->pointers[i]);
-    }
     for (size_t i = 0; i < data->struct_count; i++) {
         codegen_data_struct_destroy(data->structs[i]);
     }
+    for (size_t i = 0; i < CODEGEN_SYMBOL_TOTAL; i++) {
+        free(data->symbols[i].slots);
+    }
     free(data->functions);
-    free(data->variables);
-    free(data->arrays);
-    free(data->pointers);
+    free(data->structs);
+    free(data->bindings);
+    free(data->scopes);
     free(data);
 }
 
@@ -52,50 +123,68 @@ void codegen_data_add_function(CodegenData* data, CodegenData_Function* function
     data->functions = realloc(data->functions, sizeof(CodegenData_Function*) * (data->function_count + 1));
     data->functions[data->function_count] = function;
     data->function_count++;
+    // Of several functions with one name the first is the one that is called
+    CodegenData_SymbolSlot* slot = codegen_data_symbol_insert(&data->symbols[CODEGEN_SYMBOL_FUNCTION], function->function_name_id);
+    if (slot->value == NULL) {
+        slot->value = function;
+    }
 }
 
 void codegen_data_add_variable(CodegenData* data, CodegenData_Variable* variable) {
-    data->variables = realloc(data->variables, sizeof(CodegenData_Variable*) * (data->variable_count + 1));
-    data->variables[data->variable_count] = variable;
-    data->variable_count++;
+    codegen_data_bind(data, CODEGEN_SYMBOL_VARIABLE, variable->variable_name_id, variable);
 }
 void codegen_data_add_array(CodegenData* data, CodegenData_Array* array) {
-    data->arrays = realloc(data->arrays, sizeof(CodegenData_Array*) * (data->array_count + 1));
-    data->arrays[data->array_count] = array;
-    data->array_count++;
+    codegen_data_bind(data, CODEGEN_SYMBOL_ARRAY, array->array_name_id, array);
 }
 
 void codegen_data_add_pointer(CodegenData* data, CodegenData_Pointer* pointer) {
-    data->pointers = realloc(data->pointers, sizeof(CodegenData_Pointer*) * (data->pointer_count + 1));
-    data->pointers[data->pointer_count] = pointer;
-    data->pointer_count++;
+    codegen_data_bind(data, CODEGEN_SYMBOL_POINTER, pointer->pointer_name_id, pointer);
 }
 
 void codegen_data_add_struct(CodegenData* data, CodegenData_Struct* strukt) {
     data->structs = realloc(data->structs, sizeof(CodegenData_Struct*) * (data->struct_count + 1));
     data->structs[data->struct_count] = strukt;
     data->struct_count++;
+    CodegenData_SymbolSlot* slot = codegen_data_symbol_insert(&data->symbols[CODEGEN_SYMBOL_STRUCT], strukt->struct_name_id);
+    if (slot->value == NULL) {
+        slot->value = strukt;
+    }
+}
+
+void codegen_data_add_parameters(CodegenData* data, CodegenData_Function* function) {
+    for (size_t i = 0; i < function->parameter_count; i++) {
+        codegen_data_bind(data, CODEGEN_SYMBOL_PARAMETER, function->parameter_name_ids[i], function->parameters[i]);
+    }
 }
 
 CodegenData_Function* codegen_data_create_function(const char* function_name, LLVMValueRef function, LLVMTypeRef return_type, LLVMTypeRef* parameter_types, LLVMValueRef* parameters, size_t parameter_count, bool is_vararg) {
     CodegenData_Function* function_data = malloc(sizeof(CodegenData_Function));
     function_data->function_name = function_name;
+    function_data->function_name_id = interner_find(interner, function_name);
     function_data->function = function;
     function_data->return_type = return_type;
     function_data->parameter_types = parameter_types;
     function_data->parameter_count = parameter_count;
     function_data->parameters = parameters;
+    function_data->parameter_name_ids = malloc(sizeof(uint32_t) * parameter_count);
+    for (size_t i = 0; i < parameter_count; i++) {
+        function_data->parameter_name_ids[i] = interner_find(interner, LLVMGetValueName(parameters[i]));
+    }
     function_data->is_vararg = is_vararg;
     return function_data;
 }
 
 void codegen_data_function_destroy(CodegenData_Function* function) {
+    free(function->parameter_types);
+    free(function->parameters);
+    free(function->parameter_name_ids);
     free(function);
 }
 
 CodegenData_Variable* codegen_data_create_variable(const char* variable_name, LLVMValueRef variable, const char* variable_type_name, LLVMTypeRef variable_type) {
     CodegenData_Variable* variable_data = malloc(sizeof(CodegenData_Variable));
     variable_data->variable_name = variable_name;
+    variable_data->variable_name_id = interner_find(interner, variable_name);
     variable_data->variable = variable;
     variable_data->variable_type = variable_type;
     variable_data->variable_type_name = variable_type_name;
@@ -109,6 +198,7 @@ void codegen_data_variable_destroy(CodegenData_Variable* variable) {
 CodegenData_Array* codegen_data_create_array(const char* array_name, LLVMValueRef array, LLVMTypeRef array_type, LLVMTypeRef array_element_type, size_t array_dim) {
     CodegenData_Array* array_data = malloc(sizeof(CodegenData_Array));
     array_data->array_name = array_name;
+    array_data->array_name_id = interner_find(interner, array_name);
     array_data->array = array;
     array_data->array_type = array_type;
     array_data->array_element_type = array_element_type;
@@ -123,6 +213,7 @@ void codegen_data_array_destroy(CodegenData_Array* array) {
 CodegenData_Pointer* codegen_data_create_pointer(const char* pointer_name, const char* pointer_base_type_name, LLVMValueRef pointer, LLVMTypeRef pointer_type, LLVMTypeRef pointer_base_type, size_t pointer_degree) {
     CodegenData_Pointer* pointer_data = malloc(sizeof(CodegenData_Pointer));
     pointer_data->pointer_name = pointer_name;
+    pointer_data->pointer_name_id = interner_find(interner, pointer_name);
     pointer_data->pointer_base_type_name = pointer_base_type_name;
     pointer_data->pointer = pointer;
     pointer_data->pointer_type = pointer_type;
@@ -138,6 +229,7 @@ void codegen_data_pointer_destroy(CodegenData_Pointer* pointer) {
 CodegenData_Struct* codegen_data_create_struct(const char* struct_name, LLVMTypeRef struct_type, LLVMTypeRef* struct_member_types, char** member_type_names, char** struct_member_names, size_t struct_member_count) {
     CodegenData_Struct* strukt = malloc(sizeof(CodegenData_Struct));
     strukt->struct_name = struct_name;
+    strukt->struct_name_id = interner_find(interner, struct_name);
     strukt->struct_type = struct_type;
     strukt->struct_member_types = struct_member_types;
     strukt->struct_member_type_names = member_type_names;
@@ -152,64 +244,44 @@ void codegen_data_struct_destroy(CodegenData_Struct* strukt) {
     free(strukt);
 }
 
-void codegen_data_reset_scope(CodegenData* data) {
-    for (size_t i = 0; i < data->variable_count; i++) {
-        codegen_data_variable_destroy(data->variables[i]);
-    }
-    for (size_t i = 0; i < data->array_count; i++) {
-        codegen_data_array_destroy(data->arrays[i]);
+void codegen_data_push_scope(CodegenData* data) {
+    if (data->scope_count == data->scope_capacity) {
+        data->scope_capacity = data->scope_capacity == 0 ? 16 : data->scope_capacity * 2;
+        data->scopes = realloc(data->scopes, sizeof(size_t) * data->scope_capacity);
     }
-    for (size_t i = 0; i < data->pointer_count; i++) {
-        codegen_data_pointer_destroy(data->pointers[i]);
+    data->scopes[data->scope_count++] = data->binding_count;
+}
+
+void codegen_data_pop_scope(CodegenData* data) {
+    codegen_data_unbind(data, data->scopes[--data->scope_count]);
+}
+
+void* codegen_data_lookup(CodegenData* data, CodegenData_SymbolKind kind, uint32_t name_id) {
+    if (name_id == INTERNER_NONE) {
+        return NULL;
     }
-    data->variable_count = 0;
-    data->array_count = 0;
-    data->pointer_count = 0;
+    CodegenData_SymbolSlot* slot = codegen_data_symbol_find(&data->symbols[kind], name_id);
+    return slot != NULL ? slot->value : NULL;
 }
 
 CodegenData_Function* codegen_data_get_function(CodegenData* data, const char* function_name) {
-    for (size_t i = 0; i < data->function_count; i++) {
-        if (strcmp(data->functions[i]->function_name, function_name) == 0) {
-            return data->functions[i];
-        }
-    }
-    return NULL;
+    return codegen_data_lookup(data, CODEGEN_SYMBOL_FUNCTION, interner_find(interner, function_name));
 }
 
 CodegenData_Variable* codegen_data_get_variable(CodegenData* data, const char* variable_name) {
-    for (size_t i = 0; i < data->variable_count; i++) {
-        if (strcmp(data->variables[i]->variable_name, variable_name) == 0) {
-            return data->variables[i];
-        }
-    }
-    return NULL;
+    return codegen_data_lookup(data, CODEGEN_SYMBOL_VARIABLE, interner_find(interner, variable_name));
 }
 
 CodegenData_Array* codegen_data_get_array(CodegenData* data, const char* array_name) {
-    for (size_t i = 0; i < data->array_count; i++) {
-        if (strcmp(data->arrays[i]->array_name, array_name) == 0) {
-            return data->arrays[i];
-        }
-    }
-    return NULL;
+    return codegen_data_lookup(data, CODEGEN_SYMBOL_ARRAY, interner_find(interner, array_name));
 }
 
 CodegenData_Pointer* codegen_data_get_pointer(CodegenData* data, const char* pointer_name) {
-    for (size_t i = 0; i < data->pointer_count; i++) {
-        if (strcmp(data->pointers[i]->pointer_name, pointer_name) == 0) {
-            return data->pointers[i];
-        }
-    }
-    return NULL;
+    return codegen_data_lookup(data, CODEGEN_SYMBOL_POINTER, interner_find(interner, pointer_name));
 }
 
 CodegenData_Struct* codegen_data_get_struct(CodegenData* data, const char* struct_name) {
-    for (size_t i = 0; i < data->struct_count; i++) {
-        if (strcmp(data->structs[i]->struct_name, struct_name) == 0) {
-            return data->structs[i];
-        }
-    }
-    return NULL;
+    return codegen_data_lookup(data, CODEGEN_SYMBOL_STRUCT, interner_find(interner, struct_name));
 }
 
 void codegen_data_set_while_merge_block(CodegenData* data, LLVMBasicBlockRef while_merge_block) {
@@ -0,0 +1,125 @@
+#include "utils/interner.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERNER_CHUNK_SIZE (64 * 1024)
+#define INTERNER_INITIAL_SLOTS 1024
+
+struct InternerChunk {
+    InternerChunk* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+};
+
+_Thread_local Interner* interner = NULL;
+
+static uint32_t interner_hash(const char* string, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)string[i]) * 16777619u;
+    }
+    return hash;
+}
+
+Interner* interner_create() {
+    Interner* interner = malloc(sizeof(Interner));
+    interner->entry_count = 1;  // Skip INTERNER_NONE
+    interner->entry_capacity = INTERNER_INITIAL_SLOTS / 2;
+    interner->entries = malloc(sizeof(InternerEntry) * interner->entry_capacity);
+    interner->entries[INTERNER_NONE] = (InternerEntry){"", 0, 0};
+    interner->slot_count = INTERNER_INITIAL_SLOTS;
+    interner->slots = calloc(interner->slot_count, sizeof(uint32_t));
+    interner->chunks = NULL;
+    return interner;
+}
+
+void interner_destroy(Interner* interner) {
+    InternerChunk* chunk = interner->chunks;
+    while (chunk != NULL) {
+        InternerChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(interner->entries);
+    free(interner->slots);
+    free(interner);
+}
+
+static char* interner_copy(Interner* interner, const char* string, size_t length) {
+    InternerChunk* chunk = interner->chunks;
+    if (chunk == NULL || chunk->capacity - chunk->used < length + 1) {
+        size_t capacity = length + 1 > INTERNER_CHUNK_SIZE ? length + 1 : INTERNER_CHUNK_SIZE;
+        chunk = malloc(sizeof(InternerChunk) + capacity);
+        chunk->next = interner->chunks;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        interner->chunks = chunk;
+    }
+    char* copy = chunk->data + chunk->used;
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+    chunk->used += length + 1;
+    return copy;
+}
+
+// Doubles the slot table once it is half full, keeping probe chains short
+static void interner_grow(Interner* interner) {
+    free(interner->slots);
+    interner->slot_count *= 2;
+    interner->slots = calloc(interner->slot_count, sizeof(uint32_t));
+    for (uint32_t id = 1; id < interner->entry_count; id++) {
+        size_t slot = interner->entries[id].hash & (interner->slot_count - 1);
+        while (interner->slots[slot] != INTERNER_NONE) {
+            slot = (slot + 1) & (interner->slot_count - 1);
+        }
+        interner->slots[slot] = id;
+    }
+}
+
+// Slot holding string, or the free slot where it would go
+static size_t interner_probe(Interner* interner, const char* string, size_t length, uint32_t hash) {
+    size_t slot = hash & (interner->slot_count - 1);
+    while (interner->slots[slot] != INTERNER_NONE) {
+        InternerEntry* entry = &interner->entries[interner->slots[slot]];
+        if (entry->hash == hash && entry->length == length && memcmp(entry->string, string, length) == 0) {
+            break;
+        }
+        slot = (slot + 1) & (interner->slot_count - 1);
+    }
+    return slot;
+}
+
+uint32_t interner_intern(Interner* interner, const char* string, size_t length) {
+    uint32_t hash = interner_hash(string, length);
+    size_t slot = interner_probe(interner, string, length, hash);
+    if (interner->slots[slot] != INTERNER_NONE) {
+        return interner->slots[slot];
+    }
+
+    if (interner->entry_count == interner->entry_capacity) {
+        interner->entry_capacity *= 2;
+        interner->entries = realloc(interner->entries, sizeof(InternerEntry) * interner->entry_capacity);
+    }
+    uint32_t id = interner->entry_count++;
+    interner->entries[id] = (InternerEntry){interner_copy(interner, string, length), length, hash};
+    interner->slots[slot] = id;
+    if (interner->entry_count * 2 > interner->slot_count) {
+        interner_grow(interner);
+    }
+    return id;
+}
+
+uint32_t interner_id(Interner* interner, const char* string) {
+    return interner_intern(interner, string, strlen(string));
+}
+
+uint32_t interner_find(Interner* interner, const char* string) {
+    size_t length = strlen(string);
+    return interner->slots[interner_probe(interner, string, length, interner_hash(string, length))];
+}
+
+const char* interner_string(Interner* interner, uint32_t id) {
+    return interner->entries[id].string;
+}
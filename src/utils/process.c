@@ -0,0 +1,30 @@
+#include "utils/process.h"
+
+#ifdef _WIN32
+#include <process.h>
+#include <stdint.h>
+#else
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+int process_run(char* const* argv) {
+#ifdef _WIN32
+    intptr_t status = _spawnvp(_P_WAIT, argv[0], (const char* const*)argv);
+    return status < 0 ? -1 : (int)status;
+#else
+    pid_t pid = fork();
+    if (pid < 0) {
+        return -1;
+    }
+    if (pid == 0) {
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+#endif
+}
@@ -0,0 +1,12 @@
+#include "utils/recovery.h"
+
+#include <stdlib.h>
+
+_Thread_local jmp_buf* recovery_point = NULL;
+
+_Noreturn void recovery_fail() {
+    if (recovery_point == NULL) {
+        exit(1);
+    }
+    longjmp(*recovery_point, 1);
+}
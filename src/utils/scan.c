@@ -0,0 +1,190 @@
+#include "utils/scan.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static inline bool scan_is_identifier(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+static size_t scan_whitespace_scalar(const char *text, size_t *line, size_t *column) {
+    size_t i = 0;
+    while (true) {
+        char c = text[i];
+        if (c == '\n') {
+            (*line)++;
+            *column = 1;
+        } else if (c == '\t') {
+            *column += 4;
+        } else if (c == ' ' || c == '\r') {
+            (*column)++;
+        } else {
+            return i;
+        }
+        i++;
+    }
+}
+
+static size_t scan_identifier_scalar(const char *text) {
+    size_t i = 0;
+    while (scan_is_identifier(text[i])) {
+        i++;
+    }
+    return i;
+}
+
+static size_t scan_until_scalar(const char *text, char stop) {
+    size_t i = 0;
+    while (text[i] != stop && text[i] != '\0') {
+        i++;
+    }
+    return i;
+}
+
+#ifdef SCAN_X86
+// Applies a run of whitespace described by bit masks over one block: `run`
+// holds the bytes that were skipped, `newlines` and `tabs` the kinds of them.
+static inline void scan_count_whitespace(uint64_t run, uint64_t newlines, uint64_t tabs, size_t *line, size_t *column) {
+    newlines &= run;
+    if (newlines != 0) {
+        *line += __builtin_popcountll(newlines);
+        *column = 1;
+        int last = 63 - __builtin_clzll(newlines);
+        run &= ~((2ull << last) - 1);
+    }
+    size_t tab_count = __builtin_popcountll(tabs & run);
+    *column += (size_t)__builtin_popcountll(run) - tab_count + tab_count * 4;
+}
+
+static size_t scan_whitespace_sse2(const char *text, size_t *line, size_t *column) {
+    size_t i = 0;
+    while (true) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(text + i));
+        __m128i newline = _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'));
+        __m128i tab = _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'));
+        __m128i other = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\r')));
+        uint32_t space = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(newline, tab), other));
+        uint32_t stop = ~space & 0xFFFF;
+        uint64_t run = stop == 0 ? 0xFFFF : (1u << __builtin_ctz(stop)) - 1;
+        scan_count_whitespace(run, _mm_movemask_epi8(newline), _mm_movemask_epi8(tab), line, column);
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 16;
+    }
+}
+
+static size_t scan_identifier_sse2(const char *text) {
+    size_t i = 0;
+    while (true) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(text + i));
+        __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+        __m128i extra = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('_')), _mm_cmpeq_epi8(block, _mm_set1_epi8('-')));
+        uint32_t ident = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), extra));
+        uint32_t stop = ~ident & 0xFFFF;
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 16;
+    }
+}
+
+static size_t scan_until_sse2(const char *text, char stop_char) {
+    size_t i = 0;
+    while (true) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(text + i));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(stop_char)), _mm_cmpeq_epi8(block, _mm_setzero_si128()));
+        uint32_t stop = _mm_movemask_epi8(hit);
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 16;
+    }
+}
+
+__attribute__((target("avx2"))) static size_t scan_whitespace_avx2(const char *text, size_t *line, size_t *column) {
+    size_t i = 0;
+    while (true) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(text + i));
+        __m256i newline = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'));
+        __m256i tab = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t'));
+        __m256i other = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r')));
+        uint32_t space = _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(newline, tab), other));
+        uint32_t stop = ~space;
+        uint64_t run = stop == 0 ? 0xFFFFFFFFull : (1ull << __builtin_ctz(stop)) - 1;
+        scan_count_whitespace(run, (uint32_t)_mm256_movemask_epi8(newline), (uint32_t)_mm256_movemask_epi8(tab), line, column);
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 32;
+    }
+}
+
+__attribute__((target("avx2"))) static size_t scan_identifier_avx2(const char *text) {
+    size_t i = 0;
+    while (true) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(text + i));
+        __m256i lower = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+        __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), block));
+        __m256i extra = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('-')));
+        uint32_t ident = _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), extra));
+        uint32_t stop = ~ident;
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 32;
+    }
+}
+
+__attribute__((target("avx2"))) static size_t scan_until_avx2(const char *text, char stop_char) {
+    size_t i = 0;
+    while (true) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(text + i));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(stop_char)), _mm256_cmpeq_epi8(block, _mm256_setzero_si256()));
+        uint32_t stop = _mm256_movemask_epi8(hit);
+        if (stop != 0) {
+            return i + __builtin_ctz(stop);
+        }
+        i += 32;
+    }
+}
+#endif
+
+static const ScanFunctions scan_scalar = {"scalar", scan_whitespace_scalar, scan_identifier_scalar, scan_until_scalar};
+#ifdef SCAN_X86
+static const ScanFunctions scan_sse2 = {"sse2", scan_whitespace_sse2, scan_identifier_sse2, scan_until_sse2};
+static const ScanFunctions scan_avx2 = {"avx2", scan_whitespace_avx2, scan_identifier_avx2, scan_until_avx2};
+#endif
+
+ScanFunctions scan = {"scalar", scan_whitespace_scalar, scan_identifier_scalar, scan_until_scalar};
+
+void scan_init() {
+    const char *forced = getenv("SYNTHEX_SCAN");
+    scan = scan_scalar;
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (forced != NULL) {
+        if (strcmp(forced, "sse2") == 0) {
+            scan = scan_sse2;
+        } else if (strcmp(forced, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+            scan = scan_avx2;
+        }
+    } else if (__builtin_cpu_supports("avx2")) {
+        scan = scan_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        scan = scan_sse2;
+    }
+#else
+    (void)forced;
+#endif
+}
@@ -0,0 +1,50 @@
+#include "utils/thread.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static DWORD WINAPI thread_trampoline(LPVOID data) {
+    Thread* thread = data;
+    thread->function(thread->arg);
+    return 0;
+}
+#else
+static void* thread_trampoline(void* data) {
+    Thread* thread = data;
+    thread->function(thread->arg);
+    return NULL;
+}
+#endif
+
+bool thread_start(Thread* thread, ThreadFunction function, void* arg) {
+    thread->function = function;
+    thread->arg = arg;
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, thread_trampoline, thread, 0, NULL);
+    return thread->handle != NULL;
+#else
+    return pthread_create(&thread->handle, NULL, thread_trampoline, thread) == 0;
+#endif
+}
+
+void thread_join(Thread* thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
+
+size_t thread_hardware_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+#endif
+}
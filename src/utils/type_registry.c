@@ -0,0 +1,96 @@
+#include "utils/type_registry.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/ast_data.h"
+#include "utils/interner.h"
+
+#define TYPE_REGISTRY_CHUNK_SIZE 256
+#define TYPE_REGISTRY_INITIAL_SLOTS 64
+
+_Thread_local TypeRegistry* type_registry = NULL;
+
+static const char* builtin_type_names[DATA_TYPE_TOTAL] = {
+    [DATA_TYPE_I8] = "i8",   [DATA_TYPE_I16] = "i16", [DATA_TYPE_I32] = "i32",   [DATA_TYPE_I64] = "i64",
+    [DATA_TYPE_F32] = "f32", [DATA_TYPE_F64] = "f64", [DATA_TYPE_STR] = "str",   [DATA_TYPE_CHR] = "chr",
+    [DATA_TYPE_BLN] = "bln", [DATA_TYPE_VOID] = "void", [DATA_TYPE_PTR] = "ptr",
+};
+
+static size_t type_registry_home(TypeRegistry* registry, uint32_t name_id) {
+    return (name_id * 2654435761u) & (registry->slot_count - 1);
+}
+
+static size_t type_registry_slot(TypeRegistry* registry, uint32_t name_id) {
+    size_t slot = type_registry_home(registry, name_id);
+    while (registry->slots[slot] != 0 && type_registry_get(registry, registry->slots[slot] - 1)->name_id != name_id) {
+        slot = (slot + 1) & (registry->slot_count - 1);
+    }
+    return slot;
+}
+
+static void type_registry_rehash(TypeRegistry* registry) {
+    memset(registry->slots, 0, sizeof(uint32_t) * registry->slot_count);
+    for (size_t id = 0; id < registry->count; id++) {
+        registry->slots[type_registry_slot(registry, type_registry_get(registry, id)->name_id)] = id + 1;
+    }
+}
+
+static DataType* type_registry_append(TypeRegistry* registry, const char* name, uint32_t name_id, bool builtin) {
+    if (registry->count == registry->chunk_count * TYPE_REGISTRY_CHUNK_SIZE) {
+        registry->chunks = realloc(registry->chunks, sizeof(DataType*) * (registry->chunk_count + 1));
+        registry->chunks[registry->chunk_count++] = malloc(sizeof(DataType) * TYPE_REGISTRY_CHUNK_SIZE);
+    }
+    size_t id = registry->count++;
+    DataType* type = type_registry_get(registry, id);
+    *type = (DataType){
+        .id = id,
+        .name = name,
+        .name_id = name_id,
+        .builtin = builtin,
+    };
+    registry->slots[type_registry_slot(registry, name_id)] = id + 1;
+    if (registry->count * 2 > registry->slot_count) {
+        free(registry->slots);
+        registry->slot_count *= 2;
+        registry->slots = calloc(registry->slot_count, sizeof(uint32_t));
+        type_registry_rehash(registry);
+    }
+    return type;
+}
+
+TypeRegistry* type_registry_create() {
+    TypeRegistry* registry = calloc(1, sizeof(TypeRegistry));
+    registry->slot_count = TYPE_REGISTRY_INITIAL_SLOTS;
+    registry->slots = calloc(registry->slot_count, sizeof(uint32_t));
+    for (size_t i = 0; i < DATA_TYPE_TOTAL; i++) {
+        type_registry_append(registry, builtin_type_names[i], interner_id(interner, builtin_type_names[i]), true);
+    }
+    return registry;
+}
+
+void type_registry_destroy(TypeRegistry* registry) {
+    for (size_t i = 0; i < registry->chunk_count; i++) {
+        free(registry->chunks[i]);
+    }
+    free(registry->chunks);
+    free(registry->slots);
+    free(registry);
+}
+
+DataType* type_registry_add(TypeRegistry* registry, uint32_t name_id) {
+    DataType* type = type_registry_find(registry, name_id);
+    if (type != NULL) {
+        return type;
+    }
+    return type_registry_append(registry, interner_string(interner, name_id), name_id, false);
+}
+
+DataType* type_registry_find(TypeRegistry* registry, uint32_t name_id) {
+    uint32_t id = registry->slots[type_registry_slot(registry, name_id)];
+    return id == 0 ? NULL : type_registry_get(registry, id - 1);
+}
+
+DataType* type_registry_get(TypeRegistry* registry, size_t id) {
+    return &registry->chunks[id / TYPE_REGISTRY_CHUNK_SIZE][id % TYPE_REGISTRY_CHUNK_SIZE];
+}